@@ -1,6 +1,7 @@
 #include "game.hpp"
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
 
 using namespace blit;
 
@@ -17,8 +18,11 @@ const int CHUNK_WIDTH = 10;  // tiles per chunk
 const int NUM_CHUNKS = 5;    // chunks to keep in memory
 const int LEVEL_WIDTH = CHUNK_WIDTH * NUM_CHUNKS;  // 50 tiles wide buffer
 
-// Level data - circular buffer of chunks
-uint8_t level[LEVEL_WIDTH * TILES_Y];
+// Level data - circular buffer of chunks, one bitmask of solid tiles per
+// column (bit ty = tile row ty), so collision sweeps are mask tests
+static_assert(TILES_Y < 32, "a column mask holds every tile row");
+const uint32_t BELOW_LEVEL_MASK = ~((1u << TILES_Y) - 1);  // Rows below the level count as solid
+uint32_t level_columns[LEVEL_WIDTH];
 int chunk_offset = 0;  // which chunk index is leftmost in buffer
 int world_chunk_offset = 0;  // world position of leftmost chunk
 
@@ -37,12 +41,15 @@ struct Player {
 struct Gem {
     float x, y;
     bool collected;
-    bool active;
     uint8_t type;  // 0=red, 1=green, 2=blue
 };
 
-const int MAX_GEMS = 50;
-Gem gems[MAX_GEMS];
+// Gems are bucketed by ring-buffer chunk, so shifting the buffer only
+// touches the dropped and added chunks
+const int MAX_GEMS_PER_CHUNK = 20;  // Extra gems in a chunk are dropped (18 seen in 20000 chunks)
+const int MAX_GEMS = MAX_GEMS_PER_CHUNK * NUM_CHUNKS;
+Gem gems[NUM_CHUNKS][MAX_GEMS_PER_CHUNK];
+int gem_counts[NUM_CHUNKS];
 int score = 0;
 
 // Physics constants
@@ -51,6 +58,19 @@ const float JUMP_FORCE = -5.5f;
 const float MOVE_SPEED = 2.0f;
 const float FRICTION = 0.85f;
 
+// Scrolling background cache: the screen keeps last frame's background, is
+// shifted by the camera's scroll each frame, and only the newly exposed
+// columns plus the rectangles sprites were drawn over get repainted.
+// Press B to switch to full repaints for comparison.
+const int MAX_DIRTY_RECTS = MAX_GEMS + 2;  // Gems, player and UI bar
+bool scroll_cache = true;
+bool background_valid = false;  // Screen holds a background at background_scroll_x
+int background_scroll_x = 0;
+Rect dirty_rects[MAX_DIRTY_RECTS];  // Drawn over last frame, in last frame's screen space
+int dirty_count = 0;
+uint32_t background_fill_pixels = 0;  // Background pixels painted last frame
+uint32_t background_time_us = 0;
+
 // Random seed
 uint32_t seed = 34125;
 uint32_t chunk_seed = 34125;
@@ -74,21 +94,14 @@ uint32_t chunk_random_next(uint32_t &s) {
 
 // Generate a single chunk of level
 void generate_chunk(int chunk_id, int buffer_chunk_index) {
-    int base_x = buffer_chunk_index * CHUNK_WIDTH;
+    uint32_t *columns = &level_columns[buffer_chunk_index * CHUNK_WIDTH];
     
     // Use deterministic seed for this chunk
     uint32_t cseed = chunk_seed + chunk_id * 7919;
     
-    // Clear chunk
-    for (int y = 0; y < TILES_Y; y++) {
-        for (int x = 0; x < CHUNK_WIDTH; x++) {
-            level[y * LEVEL_WIDTH + base_x + x] = 0;
-        }
-    }
-    
-    // Bottom floor (always present)
+    // Clear chunk, leaving the bottom floor (always present)
     for (int x = 0; x < CHUNK_WIDTH; x++) {
-        level[(TILES_Y - 1) * LEVEL_WIDTH + base_x + x] = 1;
+        columns[x] = 1u << (TILES_Y - 1);
     }
     
     // Generate platforms for this chunk
@@ -98,43 +111,45 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
         int platform_len = chunk_random_next(cseed) % 4 + 2;
         
         for (int i = 0; i < platform_len && platform_x + i < CHUNK_WIDTH; i++) {
-            level[platform_y * LEVEL_WIDTH + base_x + platform_x + i] = 1;
+            columns[platform_x + i] |= 1u << platform_y;
         }
         
         platform_y -= chunk_random_next(cseed) % 2 + 2;
     }
     
-    // Add gems on platforms
+    // Add gems on platforms, replacing the gems of the chunk that held this slot
+    Gem *chunk_gems = gems[buffer_chunk_index];
+    int &gem_count = gem_counts[buffer_chunk_index];
+    gem_count = 0;
     int world_base_x = chunk_id * CHUNK_WIDTH * TILE_SIZE;
     for (int y = 0; y < TILES_Y - 1; y++) {
         for (int x = 0; x < CHUNK_WIDTH; x++) {
             // Check if there's a platform below and empty space here
-            if (level[y * LEVEL_WIDTH + base_x + x] == 0 &&
-                level[(y + 1) * LEVEL_WIDTH + base_x + x] == 1) {
-                    if (chunk_random_next(cseed) % 4 == 0) {
-                        // Find empty gem slot
-                        for (int i = 0; i < MAX_GEMS; i++) {
-                            if (!gems[i].active) {
-                                gems[i].x = world_base_x + x * TILE_SIZE + TILE_SIZE / 2;
-                                gems[i].y = y * TILE_SIZE + TILE_SIZE / 2;
-                                gems[i].collected = false;
-                                gems[i].active = true;
-                                gems[i].type = chunk_random_next(cseed) % 3;
-                                break;
-                            }
-                        }
-                    }
+            if (((~columns[x] & (columns[x] >> 1)) >> y) & 1) {
+                if (chunk_random_next(cseed) % 4 == 0 && gem_count < MAX_GEMS_PER_CHUNK) {
+                    Gem &gem = chunk_gems[gem_count++];
+                    gem.x = world_base_x + x * TILE_SIZE + TILE_SIZE / 2;
+                    gem.y = y * TILE_SIZE + TILE_SIZE / 2;
+                    gem.collected = false;
+                    gem.type = chunk_random_next(cseed) % 3;
                 }
             }
         }
     }
+}
     
-    // Get tile at world coordinates
-    bool is_solid_world(int world_tx, int ty) {
-        if (ty < 0 || ty >= TILES_Y) {
-            return ty >= TILES_Y;  // solid below screen, empty above
+    // Ring-buffer slot of a world chunk (-1 if it isn't loaded)
+    int chunk_slot(int chunk_id) {
+        int buffer_chunk = chunk_id - world_chunk_offset;
+        if (buffer_chunk < 0 || buffer_chunk >= NUM_CHUNKS) {
+            return -1;
         }
-        
+        return (chunk_offset + buffer_chunk) % NUM_CHUNKS;
+    }
+    
+    // Solid tiles of a world column, bit ty per row (solid below screen,
+    // empty above; columns of unloaded chunks are empty)
+    uint32_t solid_column(int world_tx) {
         // Convert world tile X to buffer position
         int chunk_id = world_tx / CHUNK_WIDTH;
         int local_x = world_tx % CHUNK_WIDTH;
@@ -143,14 +158,26 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
             chunk_id--;
         }
         
-        // Check if chunk is in our buffer
-        int buffer_chunk = chunk_id - world_chunk_offset;
-        if (buffer_chunk < 0 || buffer_chunk >= NUM_CHUNKS) {
-            return false;  // chunk not loaded, assume empty
+        int slot = chunk_slot(chunk_id);
+        if (slot < 0) {
+            return BELOW_LEVEL_MASK;
         }
-        
-        int buffer_x = ((chunk_offset + buffer_chunk) % NUM_CHUNKS) * CHUNK_WIDTH + local_x;
-        return level[ty * LEVEL_WIDTH + buffer_x] == 1;
+        return level_columns[slot * CHUNK_WIDTH + local_x] | BELOW_LEVEL_MASK;
+    }
+    
+    // Mask of tile rows first..last (rows above the screen are never solid,
+    // rows past the mask are treated as its last row)
+    uint32_t row_span_mask(int first, int last) {
+        if (first < 0) first = 0;
+        if (first > 31) first = 31;
+        if (last > 31) last = 31;
+        if (first > last) return 0;
+        return (0xFFFFFFFFu >> (31 - last)) & (0xFFFFFFFFu << first);
+    }
+    
+    // Get tile at world coordinates
+    bool is_solid_world(int world_tx, int ty) {
+        return (solid_column(world_tx) & row_span_mask(ty, ty)) != 0;
     }
     
     // Update chunks based on camera position
@@ -162,15 +189,8 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
         
         // Shift chunks if needed
         while (world_chunk_offset < desired_left_chunk) {
-            // Remove leftmost chunk, add new one on right
-            // Clear gems from old chunk
-            int old_chunk_world_x = world_chunk_offset * CHUNK_WIDTH * TILE_SIZE;
-            for (int i = 0; i < MAX_GEMS; i++) {
-                if (gems[i].active && gems[i].x < old_chunk_world_x + CHUNK_WIDTH * TILE_SIZE) {
-                    gems[i].active = false;
-                }
-            }
-            
+            // Remove leftmost chunk, add new one on right (in its slot,
+            // which drops its gems)
             world_chunk_offset++;
             chunk_offset = (chunk_offset + 1) % NUM_CHUNKS;
             
@@ -181,15 +201,7 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
         }
         
         while (world_chunk_offset > desired_left_chunk && world_chunk_offset > 0) {
-            // Remove rightmost chunk, add new one on left
-            // Clear gems from old chunk
-            int old_chunk_world_x = (world_chunk_offset + NUM_CHUNKS - 1) * CHUNK_WIDTH * TILE_SIZE;
-            for (int i = 0; i < MAX_GEMS; i++) {
-                if (gems[i].active && gems[i].x >= old_chunk_world_x) {
-                    gems[i].active = false;
-                }
-            }
-            
+            // Remove rightmost chunk, add new one on left (in its slot)
             world_chunk_offset--;
             chunk_offset = (chunk_offset + NUM_CHUNKS - 1) % NUM_CHUNKS;
             
@@ -307,8 +319,8 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
         set_screen_mode(ScreenMode::hires);
         
         // Initialize gems
-        for (int i = 0; i < MAX_GEMS; i++) {
-            gems[i].active = false;
+        for (int i = 0; i < NUM_CHUNKS; i++) {
+            gem_counts[i] = 0;
         }
         
         // Generate initial chunks
@@ -330,25 +342,31 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
         if (camera_x < 0) camera_x = 0;
     }
     
-    void render(uint32_t time) {
-        // Clear screen with sky gradient
-        for (int y = 0; y < SCREEN_H; y++) {
-            int r = 30 + y / 4;
-            int g = 40 + y / 3;
-            int b = 80 + y / 2;
-            screen.pen = Pen(r, g, b);
-            screen.rectangle(Rect(0, y, SCREEN_W, 1));
+    // Paint sky and tiles inside a screen rectangle (camera scrolled to scroll_x)
+    void paint_background(Rect r, int scroll_x) {
+        r = r.intersection(Rect(0, 0, SCREEN_W, SCREEN_H));
+        if (r.empty()) return;
+        background_fill_pixels += r.w * r.h;
+        screen.clip = r;
+        
+        // Sky gradient
+        for (int y = r.y; y < r.y + r.h; y++) {
+            int red = 30 + y / 4;
+            int green = 40 + y / 3;
+            int blue = 80 + y / 2;
+            screen.pen = Pen(red, green, blue);
+            screen.rectangle(Rect(r.x, y, r.w, 1));
         }
         
-        // Calculate visible tile range
-        int start_tile_x = (int)(camera_x / TILE_SIZE);
-        int end_tile_x = start_tile_x + (SCREEN_W / TILE_SIZE) + 2;
-        
-        // Draw tiles
+        // Tiles overlapping the rectangle
+        int start_tile_x = (int)floorf((float)(r.x + scroll_x) / TILE_SIZE);
+        int end_tile_x = (r.x + r.w - 1 + scroll_x) / TILE_SIZE;
+        int start_tile_y = r.y / TILE_SIZE;
+        int end_tile_y = (r.y + r.h - 1) / TILE_SIZE;
         for (int world_tx = start_tile_x; world_tx <= end_tile_x; world_tx++) {
-            for (int ty = 0; ty < TILES_Y; ty++) {
+            for (int ty = start_tile_y; ty <= end_tile_y; ty++) {
                 if (is_solid_world(world_tx, ty)) {
-                    int px = world_tx * TILE_SIZE - (int)camera_x;
+                    int px = world_tx * TILE_SIZE - scroll_x;
                     int py = ty * TILE_SIZE;
                     
                     // Main ground color
@@ -369,12 +387,75 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
             }
         }
         
-        // Draw gems
-        for (int i = 0; i < MAX_GEMS; i++) {
-            if (gems[i].active && !gems[i].collected) {
-                int screen_x = (int)(gems[i].x - camera_x);
-                int screen_y = (int)gems[i].y;
-                draw_gem(screen_x, screen_y, gems[i].type, time);
+        screen.clip = Rect(0, 0, SCREEN_W, SCREEN_H);
+    }
+    
+    // Shift the whole screen left by dx pixels (right if negative)
+    void scroll_screen(int dx) {
+        int row_bytes = SCREEN_W * screen.pixel_stride;
+        int shift = std::abs(dx) * screen.pixel_stride;
+        for (int y = 0; y < SCREEN_H; y++) {
+            uint8_t *row = screen.data + y * row_bytes;
+            if (dx > 0) {
+                memmove(row, row + shift, row_bytes - shift);
+            } else {
+                memmove(row + shift, row, row_bytes - shift);
+            }
+        }
+    }
+    
+    // Remember a rectangle drawn over the background this frame
+    void mark_dirty(Rect r) {
+        r = r.intersection(Rect(0, 0, SCREEN_W, SCREEN_H));
+        if (!r.empty() && dirty_count < MAX_DIRTY_RECTS) {
+            dirty_rects[dirty_count++] = r;
+        }
+    }
+    
+    void render(uint32_t time) {
+        uint32_t background_start = now_us();
+        background_fill_pixels = 0;
+        int scroll_x = (int)camera_x;
+        int dx = scroll_x - background_scroll_x;
+        
+        if (!scroll_cache || !background_valid || std::abs(dx) >= SCREEN_W) {
+            paint_background(Rect(0, 0, SCREEN_W, SCREEN_H), scroll_x);
+        } else {
+            if (dx != 0) {
+                scroll_screen(dx);
+                if (dx > 0) {
+                    paint_background(Rect(SCREEN_W - dx, 0, dx, SCREEN_H), scroll_x);
+                } else {
+                    paint_background(Rect(0, 0, -dx, SCREEN_H), scroll_x);
+                }
+            }
+            
+            // Erase last frame's sprites, which moved with the scroll
+            for (int i = 0; i < dirty_count; i++) {
+                Rect r = dirty_rects[i];
+                r.x -= dx;
+                paint_background(r, scroll_x);
+            }
+        }
+        
+        background_valid = true;
+        background_scroll_x = scroll_x;
+        dirty_count = 0;
+        background_time_us = now_us() - background_start;
+        
+        // Draw gems of the chunks on screen
+        int first_chunk = (int)floorf(camera_x / (CHUNK_WIDTH * TILE_SIZE));
+        int last_chunk = (int)floorf((camera_x + SCREEN_W) / (CHUNK_WIDTH * TILE_SIZE));
+        for (int chunk_id = first_chunk; chunk_id <= last_chunk; chunk_id++) {
+            int slot = chunk_slot(chunk_id);
+            if (slot < 0) continue;
+            for (int i = 0; i < gem_counts[slot]; i++) {
+                const Gem &gem = gems[slot][i];
+                if (gem.collected) continue;
+                int screen_x = (int)(gem.x - camera_x);
+                int screen_y = (int)gem.y;
+                draw_gem(screen_x, screen_y, gem.type, time);
+                mark_dirty(Rect(screen_x - 2, screen_y - 5, 5, 10));  // Includes the bob
             }
         }
         
@@ -386,6 +467,7 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
             anim_frame = (time / 100) % 2;
         }
         draw_chicken(player_screen_x - 4, player_screen_y - 4, player.facing_right, anim_frame, player.on_ground);
+        mark_dirty(Rect(player_screen_x - 4, player_screen_y - 4, 8, 8));
         
         // Draw UI
         screen.pen = Pen(0, 0, 0, 150);
@@ -396,6 +478,13 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
         
         int distance = (int)(player.x / TILE_SIZE);
         screen.text("Dist: " + std::to_string(distance), minimal_font, Point(180, 5));
+        
+        // Background cost: time, pixels painted as a share of the screen
+        // (tracks the scroll distance with the cache) and C = scroll cache, F = full repaint
+        int fill_pct = (int)(background_fill_pixels * 100 / (SCREEN_W * SCREEN_H));
+        screen.text("Bg:" + std::to_string(background_time_us) + "us " + std::to_string(fill_pct) + "% " +
+                    (scroll_cache ? "C" : "F"), minimal_font, Point(85, 5));
+        mark_dirty(Rect(0, 0, SCREEN_W, 16));
     }
     
     void update(uint32_t time) {
@@ -409,6 +498,12 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
             player.facing_right = true;
         }
         
+        // Toggle the background cache (for comparing render cost)
+        if (buttons.pressed & Button::B) {
+            scroll_cache = !scroll_cache;
+            background_valid = false;
+        }
+        
         // Jump
         if ((buttons.pressed & Button::A) && player.on_ground) {
             player.vy = JUMP_FORCE;
@@ -433,13 +528,7 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
         int ty1 = (int)(player.y - 3) / TILE_SIZE;
         int ty2 = (int)(player.y + 3) / TILE_SIZE;
         
-        bool h_collision = false;
-        for (int ty = ty1; ty <= ty2; ty++) {
-            if (is_solid_world(tx1, ty) || is_solid_world(tx2, ty)) {
-                h_collision = true;
-                break;
-            }
-        }
+        bool h_collision = ((solid_column(tx1) | solid_column(tx2)) & row_span_mask(ty1, ty2)) != 0;
         
         if (!h_collision) {
             player.x = new_x;
@@ -460,13 +549,12 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
         ty1 = (int)(new_y - 3) / TILE_SIZE;
         ty2 = (int)(new_y + 3) / TILE_SIZE;
         
-        bool v_collision = false;
+        // Only the top and bottom rows are tested
+        uint32_t columns = 0;
         for (int tx = tx1; tx <= tx2; tx++) {
-            if (is_solid_world(tx, ty1) || is_solid_world(tx, ty2)) {
-                v_collision = true;
-                break;
-            }
+            columns |= solid_column(tx);
         }
+        bool v_collision = (columns & (row_span_mask(ty1, ty1) | row_span_mask(ty2, ty2))) != 0;
         
         if (!v_collision) {
             player.y = new_y;
@@ -492,14 +580,20 @@ void generate_chunk(int chunk_id, int buffer_chunk_index) {
         // Update chunks based on camera
         update_chunks();
         
-        // Collect gems
-        for (int i = 0; i < MAX_GEMS; i++) {
-            if (gems[i].active && !gems[i].collected) {
-                float dx = player.x - gems[i].x;
-                float dy = player.y - gems[i].y;
+        // Collect gems in the chunks within reach (10 pixels)
+        int first_chunk = (int)floorf((player.x - 10) / (CHUNK_WIDTH * TILE_SIZE));
+        int last_chunk = (int)floorf((player.x + 10) / (CHUNK_WIDTH * TILE_SIZE));
+        for (int chunk_id = first_chunk; chunk_id <= last_chunk; chunk_id++) {
+            int slot = chunk_slot(chunk_id);
+            if (slot < 0) continue;
+            for (int i = 0; i < gem_counts[slot]; i++) {
+                Gem &gem = gems[slot][i];
+                if (gem.collected) continue;
+                float dx = player.x - gem.x;
+                float dy = player.y - gem.y;
                 if (dx * dx + dy * dy < 100) {
-                    gems[i].collected = true;
-                    score += (gems[i].type + 1) * 10;
+                    gem.collected = true;
+                    score += (gem.type + 1) * 10;
                 }
             }
         }
@@ -0,0 +1,466 @@
+#include "benchmark.hpp"
+#include "rasterizer.hpp"
+#include "city.hpp"
+#include "texture.hpp"
+#include <algorithm>
+
+struct BenchmarkScene {
+    uint32_t seed;
+    float x, z, yaw;   // Player at the first frame
+    float step, turn;  // Forward movement and yaw change per frame
+};
+
+static const BenchmarkScene benchmark_scenes[BENCHMARK_SCENES] = {
+    {12345, 5.0f, 0.0f, 0.0f, 0.25f, 0.0f},      // Down a street
+    {777, 30.0f, 10.0f, 1.2f, 0.1f, 0.04f},      // Turning between blocks
+    {4242, 60.0f, -30.0f, -0.7f, 0.3f, -0.02f},  // Diagonal across the grid
+    {99, 100.0f, 45.0f, 3.14f, 0.0f, 0.1f},      // Spinning on the spot
+};
+
+// Times of a known-good build in microseconds, {build, raster}
+// (0 = not recorded yet, the time check is skipped)
+#if BENCHMARK_HOST
+// Median of 20 runs of the host test, -O3 x86-64 (GCC 12), at a calibration
+// time of HOST_CALIBRATION_BASELINE_US
+static const uint32_t benchmark_baseline_us[BENCHMARK_SCENES][2] = {
+    {1105, 3780}, {1350, 4500}, {1380, 4950}, {1280, 4250},
+};
+#else
+static const uint32_t benchmark_baseline_us[BENCHMARK_SCENES][2] = {
+    {0, 0}, {0, 0}, {0, 0}, {0, 0},
+};
+#endif
+
+// Last frame of each scene from a known-good build (benchmark_reduce_image)
+extern const uint32_t benchmark_reference[BENCHMARK_SCENES][BENCHMARK_CELLS * BENCHMARK_CELLS];
+
+static bool window_live(float x, float z) {
+    int cx = city_chunk_of(x), cz = city_chunk_of(z);
+    for (int dz = -city_window_radius; dz <= city_window_radius; dz++) {
+        for (int dx = -city_window_radius; dx <= city_window_radius; dx++) {
+            if (city_chunk_state(cx + dx, cz + dz) != CHUNK_LIVE) return false;
+        }
+    }
+    return true;
+}
+
+// Stream synchronously until the whole window around (x, z) is live, so
+// frames don't depend on timing
+static void load_window(float x, float z) {
+    for (int pass = 0; pass < CITY_WINDOW_SLOTS && !window_live(x, z); pass++) {
+        city_update_chunks(x, z, UINT32_MAX);
+    }
+}
+
+static uint32_t render_current_list(uint32_t count, color_t* fb) {
+    uint32_t start = time_us();
+#if RASTER_INDEXED_COLOR
+    rasterizer_render_indexed(count);
+#else
+    rasterizer_render_to_buffer(count, fb);
+#endif
+    return time_us() - start;
+}
+
+// Render one frame of a path at a viewport size, adding its times; returns
+// the triangle count
+static uint32_t render_frame(float x, float z, float yaw, int frame, int size, color_t* fb,
+                             uint32_t& build_us, uint32_t& raster_us) {
+    load_window(x, z);
+
+    uint32_t start = time_us();
+    render3d_begin_frame();
+    render3d_set_viewport(size, size);
+    render3d_third_person_camera(x, 0.0f, z, yaw);
+    city_build_occluders();
+    city_render_floor(x, z);
+    city_render();
+    uint32_t triangles = rasterizer_get_triangle_count();
+    rasterizer_swap_lists();
+    uint32_t built = time_us();
+
+#if RASTER_INDEXED_COLOR
+    rasterizer_render_indexed(triangles);
+    rasterizer_expand_to_buffer(fb);
+#else
+    rasterizer_render_to_buffer(triangles, fb);
+#endif
+    uint32_t rastered = time_us();
+
+    // Billboards test against the depth just rendered, at a fixed time
+    render3d_swap_depth_buffers();
+    city_render_gems(frame * 16, fb);
+    build_us += (built - start) + (time_us() - rastered);
+    raster_us += rastered - built;
+    return triangles;
+}
+
+// The player moves along -(sin yaw, cos yaw)
+static void step_path(const BenchmarkScene& path, float& x, float& z, float& yaw) {
+    x -= sinf(yaw) * path.step;
+    z -= cosf(yaw) * path.step;
+    yaw += path.turn;
+}
+
+void benchmark_render_scene(int scene, color_t* fb, BenchmarkResult& result) {
+    const BenchmarkScene& path = benchmark_scenes[scene];
+    city_init(path.seed);
+    render3d_clear();
+    result.build_us = 0;
+    result.raster_us = 0;
+
+    float x = path.x, z = path.z, yaw = path.yaw;
+    for (int frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+        result.triangles = render_frame(x, z, yaw, frame, SCREEN_WIDTH, fb, result.build_us, result.raster_us);
+        step_path(path, x, z, yaw);
+    }
+}
+
+void benchmark_resolution(color_t* fb, uint32_t target_us, bool adapt, ResolutionRun& result) {
+    uint64_t sum = 0, sum_sq = 0;
+    result.max_us = 0;
+    result.over_target = 0;
+    result.smallest = SCREEN_WIDTH;
+    for (int scene = 0; scene < BENCHMARK_SCENES; scene++) {
+        const BenchmarkScene& path = benchmark_scenes[scene];
+        city_init(path.seed);
+        render3d_clear();
+        ResolutionState state = {};
+
+        float x = path.x, z = path.z, yaw = path.yaw;
+        for (int frame = 0; frame < BENCHMARK_RESOLUTION_FRAMES; frame++) {
+            uint32_t build_us = 0, raster_us = 0;
+            uint32_t triangles = render_frame(x, z, yaw, frame, resolution_size(state), fb, build_us, raster_us);
+            // Fastest of a few rasterizations, as the host's preemption isn't part of the frame
+            for (int run = 1; run < BENCHMARK_BACKEND_RUNS; run++) {
+                raster_us = std::min(raster_us, render_current_list(triangles, fb));
+            }
+            result.smallest = std::min(result.smallest, resolution_size(state));
+            resolution_update(state, raster_us, target_us, adapt);
+            step_path(path, x, z, yaw);
+
+            sum += raster_us;
+            sum_sq += (uint64_t)raster_us * raster_us;
+            result.max_us = std::max(result.max_us, raster_us);
+            if (raster_us > target_us) result.over_target++;
+        }
+    }
+    const uint32_t frames = BENCHMARK_SCENES * BENCHMARK_RESOLUTION_FRAMES;
+    result.mean_us = (uint32_t)(sum / frames);
+    result.deviation_us = (uint32_t)sqrtf((float)(sum_sq / frames - (uint64_t)result.mean_us * result.mean_us));
+}
+
+void benchmark_reduce_image(const color_t* fb, uint32_t* cells) {
+    const int n = BENCHMARK_CELL_SIZE * BENCHMARK_CELL_SIZE;
+    for (int cy = 0; cy < BENCHMARK_CELLS; cy++) {
+        for (int cx = 0; cx < BENCHMARK_CELLS; cx++) {
+            uint32_t r = 0, g = 0, b = 0;
+            for (int y = 0; y < BENCHMARK_CELL_SIZE; y++) {
+                const color_t* row = &fb[(cy * BENCHMARK_CELL_SIZE + y) * SCREEN_WIDTH + cx * BENCHMARK_CELL_SIZE];
+                for (int x = 0; x < BENCHMARK_CELL_SIZE; x++) {
+                    // ggggbbbbaaaarrrr
+                    r += row[x] & 0xF;
+                    b += (row[x] >> 8) & 0xF;
+                    g += row[x] >> 12;
+                }
+            }
+            r = (r * 17 + n / 2) / n;
+            g = (g * 17 + n / 2) / n;
+            b = (b * 17 + n / 2) / n;
+            cells[cy * BENCHMARK_CELLS + cx] = (r << 16) | (g << 8) | b;
+        }
+    }
+}
+
+static int cell_difference(uint32_t a, uint32_t b) {
+    int diff = 0;
+    for (int shift = 0; shift <= 16; shift += 8) {
+        int d = abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+        if (d > diff) diff = d;
+    }
+    return diff;
+}
+
+// FNV-1a over the frame's colour and depth
+static uint32_t frame_hash(const color_t* fb) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
+        hash = (hash ^ fb[i]) * 16777619u;
+        hash = (hash ^ depth_buffer_render[i]) * 16777619u;
+    }
+    return hash;
+}
+
+#if BENCHMARK_HOST
+// Hosts differ in speed, so host baselines are scaled by the time
+// of a fixed workload, taken with them and again at each run
+constexpr int HOST_CALIBRATION_HASHES = 64;
+constexpr int HOST_CALIBRATION_RUNS = 5;  // Fastest of this many
+constexpr uint32_t HOST_CALIBRATION_BASELINE_US = 2655;  // With benchmark_baseline_us
+
+static uint32_t host_calibration_us(const color_t* fb) {
+    uint32_t fastest = UINT32_MAX, hash = 0;
+    for (int run = 0; run < HOST_CALIBRATION_RUNS; run++) {
+        uint32_t start = time_us();
+        for (int i = 0; i < HOST_CALIBRATION_HASHES; i++) hash += frame_hash(fb);
+        fastest = std::min(fastest, time_us() - start);
+    }
+    volatile uint32_t sink = hash;  // Keep the hashes
+    (void)sink;
+    return fastest;
+}
+#endif
+
+static bool within_baseline(uint32_t time, uint32_t baseline, uint32_t calibration_us) {
+#if BENCHMARK_HOST
+    baseline = (uint32_t)((uint64_t)baseline * calibration_us / HOST_CALIBRATION_BASELINE_US);
+#endif
+    return baseline == 0 || time * 100 <= baseline * (100 + BENCHMARK_TIME_TOLERANCE_PCT);
+}
+
+bool benchmark_run(color_t* fb, BenchmarkResult results[BENCHMARK_SCENES]) {
+    static uint32_t cells[BENCHMARK_CELLS * BENCHMARK_CELLS];
+    bool passed = true;
+#if BENCHMARK_HOST
+    uint32_t calibration_us = host_calibration_us(fb);
+#else
+    uint32_t calibration_us = 0;
+#endif
+    for (int scene = 0; scene < BENCHMARK_SCENES; scene++) {
+        BenchmarkResult& result = results[scene];
+        benchmark_render_scene(scene, fb, result);
+
+        benchmark_reduce_image(fb, cells);
+        result.max_error = 0;
+        result.bad_cells = 0;
+        for (int i = 0; i < BENCHMARK_CELLS * BENCHMARK_CELLS; i++) {
+            int diff = cell_difference(cells[i], benchmark_reference[scene][i]);
+            if (diff > result.max_error) result.max_error = diff;
+            if (diff > BENCHMARK_CELL_TOLERANCE) result.bad_cells++;
+        }
+        result.image_ok = result.bad_cells <= BENCHMARK_MAX_BAD_CELLS;
+        result.time_ok = within_baseline(result.build_us, benchmark_baseline_us[scene][0], calibration_us) &&
+                         within_baseline(result.raster_us, benchmark_baseline_us[scene][1], calibration_us);
+        passed = passed && result.image_ok && result.time_ok;
+    }
+    return passed;
+}
+
+const StressWorkload benchmark_stress_sweep[BENCHMARK_STRESS_SWEEP] = {
+    // Size: setup cost against fill cost
+    {1, 4, STRESS_FLAT, STRESS_RANDOM},
+    {4, 4, STRESS_FLAT, STRESS_RANDOM},
+    {16, 4, STRESS_FLAT, STRESS_RANDOM},
+    {48, 4, STRESS_FLAT, STRESS_RANDOM},
+    {119, 4, STRESS_FLAT, STRESS_RANDOM},
+    // Depth order: early rejection against writes
+    {16, 4, STRESS_FLAT, STRESS_FRONT_TO_BACK},
+    {16, 4, STRESS_FLAT, STRESS_BACK_TO_FRONT},
+    // Shading (overdraw 2 keeps leg 16 within MAX_TEXTURED_TRIANGLES)
+    {16, 2, STRESS_GOURAUD, STRESS_RANDOM},
+    {119, 4, STRESS_GOURAUD, STRESS_RANDOM},
+    {16, 2, STRESS_TEXTURED, STRESS_RANDOM},
+    {119, 4, STRESS_TEXTURED, STRESS_RANDOM},
+    // Overdraw
+    {16, 1, STRESS_FLAT, STRESS_RANDOM},
+    {16, 8, STRESS_FLAT, STRESS_RANDOM},
+};
+
+void benchmark_compare_backends(color_t* fb, BackendComparison results[BENCHMARK_SCENES]) {
+    static uint32_t edge_cells[BENCHMARK_CELLS * BENCHMARK_CELLS];
+    static uint32_t cells[BENCHMARK_CELLS * BENCHMARK_CELLS];
+    RasterBackend selected = rasterizer_get_backend();
+    for (int scene = 0; scene < BENCHMARK_SCENES; scene++) {
+        BackendComparison& result = results[scene];
+        BenchmarkResult rendered;
+        rasterizer_set_backend(RASTER_BACKEND_EDGE);
+        benchmark_render_scene(scene, fb, rendered);
+        result.triangles = rendered.triangles;
+        result.identical = true;
+        result.max_error = 0;
+
+        // The last frame's list is still the current one
+        uint32_t edge_hash = 0;
+        for (int backend = 0; backend < RASTER_BACKEND_COUNT; backend++) {
+            rasterizer_set_backend((RasterBackend)backend);
+            result.raster_us[backend] = UINT32_MAX;
+            for (int run = 0; run < BENCHMARK_BACKEND_RUNS; run++) {
+                result.raster_us[backend] = std::min(result.raster_us[backend],
+                                                     render_current_list(result.triangles, fb));
+            }
+#if RASTER_INDEXED_COLOR
+            rasterizer_expand_to_buffer(fb);
+#endif
+            uint32_t hash = frame_hash(fb);
+            benchmark_reduce_image(fb, backend == RASTER_BACKEND_EDGE ? edge_cells : cells);
+            if (backend == RASTER_BACKEND_EDGE) {
+                edge_hash = hash;
+                continue;
+            }
+            result.identical = result.identical && hash == edge_hash;
+            for (int i = 0; i < BENCHMARK_CELLS * BENCHMARK_CELLS; i++) {
+                result.max_error = std::max(result.max_error, cell_difference(cells[i], edge_cells[i]));
+            }
+        }
+    }
+    rasterizer_set_backend(selected);
+}
+
+void benchmark_stress(const StressWorkload& workload, color_t* fb, StressResult& result) {
+    int leg = std::min(std::max((int)workload.leg, 1), SCREEN_WIDTH - 1);
+    uint32_t count = (uint32_t)workload.overdraw * SCREEN_WIDTH * SCREEN_HEIGHT * 2 / (leg * leg);
+    count = std::min(std::max(count, 1u), (uint32_t)MAX_TRIANGLES);
+
+    // Frame clear on its own, to subtract
+    rasterizer_begin_frame();
+    rasterizer_set_viewport(SCREEN_WIDTH, SCREEN_HEIGHT);
+    rasterizer_swap_lists();
+    uint32_t clear_us = render_current_list(0, fb);
+
+    rasterizer_begin_frame();
+    rasterizer_set_viewport(SCREEN_WIDTH, SCREEN_HEIGHT);
+    uint8_t colors[3] = {
+        rasterizer_palette_index(200, 80, 60),
+        rasterizer_palette_index(60, 200, 80),
+        rasterizer_palette_index(80, 60, 200),
+    };
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t x = city_random(seed) % (SCREEN_WIDTH - leg);
+        int32_t y = city_random(seed) % (SCREEN_HEIGHT - leg);
+        int32_t z;
+        switch (workload.order) {
+            case STRESS_FRONT_TO_BACK: z = 64 + (int32_t)(i * 896 / count); break;
+            case STRESS_BACK_TO_FRONT: z = 960 - (int32_t)(i * 896 / count); break;
+            default: z = 64 + city_random(seed) % 897; break;
+        }
+
+        // Alternate the upper-left and lower-right halves of the square, both front-facing
+        RasterTriangle tri;
+        if (i & 1) {
+            raster_pack_vertex(x + leg, y + leg, z, tri.v1);
+            raster_pack_vertex(x + leg, y, z, tri.v2);
+            raster_pack_vertex(x, y + leg, z, tri.v3);
+        } else {
+            raster_pack_vertex(x, y, z, tri.v1);
+            raster_pack_vertex(x, y + leg, z, tri.v2);
+            raster_pack_vertex(x + leg, y, z, tri.v3);
+        }
+        uint8_t base = i % 3;
+        tri.c1 = colors[base];
+        if (workload.shading == STRESS_TEXTURED) {
+            // One texture tile over the square the two triangle halves share
+            const uint8_t size = 1 << TEXTURE_BRICK_LOG2;
+            RasterTexCoords coords = {size, size, size, 0, 0, size, TEXTURE_BRICK, 0};
+            if (!(i & 1)) coords = {0, 0, 0, size, size, 0, TEXTURE_BRICK, 0};
+            rasterizer_submit_textured_triangle(tri, coords);
+            continue;
+        }
+        bool gouraud = workload.shading == STRESS_GOURAUD;
+        tri.c2 = gouraud ? colors[(base + 1) % 3] : tri.c1;
+        tri.c3 = gouraud ? colors[(base + 2) % 3] : tri.c1;
+        tri.flags = gouraud ? 0 : RASTER_FLAG_FLAT;
+        rasterizer_submit_triangle(tri);
+    }
+    rasterizer_swap_lists();
+    uint32_t total_us = render_current_list(count, fb);
+
+    // Edges are inclusive, so a triangle covers (leg + 1)(leg + 2) / 2 pixels
+    result.triangles = count;
+    result.pixels = count * (uint32_t)((leg + 1) * (leg + 2) / 2);
+    result.time_us = total_us > clear_us ? total_us - clear_us : 0;
+    result.ns_per_triangle = (uint32_t)((uint64_t)result.time_us * 1000 / count);
+    result.ns_per_pixel = (uint32_t)((uint64_t)result.time_us * 1000 / result.pixels);
+}
+
+// Cells of each scene's last frame, row by row (generated with benchmark_reduce_image)
+const uint32_t benchmark_reference[BENCHMARK_SCENES][BENCHMARK_CELLS * BENCHMARK_CELLS] = {
+    {
+        0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x364480, 0x9999AA, 0x9999AA, 0x9999AA, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377,
+        0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x434E80, 0x9999AA, 0x9999AA, 0x8C8EA4, 0x223377, 0x223377, 0x223377, 0x2D3E74, 0x5F797E, 0x668282,
+        0x223977, 0x223977, 0x223977, 0x223977, 0x223977, 0x223977, 0x223977, 0x223977, 0x223977, 0x223977, 0x415080, 0x9999AA, 0x9999AA, 0x8287A0, 0x223977, 0x293E77, 0x4F667A, 0x6F846F, 0x87A987, 0x88AA88,
+        0x224477, 0x224477, 0x224477, 0x224477, 0x224477, 0x224477, 0x224477, 0x224477, 0x264476, 0x7F5562, 0x816372, 0x9999AA, 0x9999AA, 0x7D88A3, 0x324F74, 0x667D6F, 0x88AA88, 0x85A685, 0x88AA88, 0x88AA88,
+        0x224488, 0x224488, 0x335588, 0x274A88, 0x2A4D88, 0x224488, 0x224488, 0x224488, 0x4D6394, 0x9999AA, 0x9797AA, 0x8989A5, 0x8888A4, 0x6D79A3, 0x455D77, 0x6F8B6F, 0x88AA88, 0x7EA47E, 0x80AA80, 0x668089,
+        0x939080, 0x765C77, 0x769688, 0xA2A181, 0x8999A1, 0x5E74A4, 0x2D4B87, 0x2E4C88, 0x4A6093, 0x9999AA, 0x9292A3, 0x888899, 0x888899, 0x5F719A, 0x46646A, 0x6B936B, 0x7DAA7D, 0x6F986F, 0x77A477, 0x658894,
+        0x8E9A7D, 0x9D8F81, 0x84A886, 0xB39B6F, 0x99949F, 0x7E8DB2, 0x5F6C82, 0x636C80, 0x485E93, 0x9393AA, 0x9090A4, 0x888899, 0x888899, 0x4F6594, 0x4E675F, 0x6E916E, 0x779F77, 0x759675, 0x6C8A77, 0x6180A6,
+        0x918D74, 0x99A988, 0x899E7F, 0x99976C, 0x958C87, 0x779198, 0x7BA768, 0x8D6670, 0x626091, 0x888899, 0x888899, 0x888899, 0x888899, 0x82869D, 0x5D6C5E, 0x749574, 0x6E8B6E, 0x779977, 0x68847A, 0x6581A9,
+        0x999980, 0xA7A786, 0x9DA381, 0x777C5C, 0x7A6F6C, 0x616175, 0x3E3E3F, 0x333333, 0x474A4F, 0x888899, 0x888899, 0x888899, 0x888899, 0x656A7C, 0x4E6A4E, 0x779977, 0x749674, 0x779977, 0x657E87, 0x6677AA,
+        0x919177, 0x99997D, 0xA29679, 0x595556, 0x505051, 0x3C3C3C, 0x333333, 0x38383A, 0x5B5B60, 0x888899, 0x868699, 0x828299, 0x828299, 0x4E5451, 0x4D734D, 0x6C996C, 0x618E61, 0x699F7A, 0x4D6B95, 0x5271A0,
+        0x66665E, 0x76655D, 0xE9504D, 0xC44442, 0x3E613F, 0x333333, 0x333334, 0x41414F, 0x48485B, 0x5E5E77, 0x5D5D75, 0x666677, 0x666677, 0x555555, 0x4F5D53, 0x556F5E, 0x4887A0, 0x4EB3FB, 0x4874A8, 0x556071,
+        0x363639, 0x9A3436, 0xBB443E, 0x6CCC39, 0x4DF94D, 0x336C33, 0x343435, 0x363639, 0x363639, 0x363639, 0x363639, 0x393939, 0x393939, 0x393939, 0x393939, 0x37485C, 0x3377BB, 0x4084BB, 0x3375B6, 0x39414C,
+        0x333333, 0x333333, 0x33A433, 0x33DD33, 0x48DD48, 0x33D733, 0x335533, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333334, 0x333333, 0x333333, 0x333333,
+        0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333,
+        0x333333, 0x333333, 0x333333, 0x333333, 0x3C3C45, 0x3E3E4A, 0x3E3E4A, 0x3E3E4A, 0x3E3E4A, 0x3E3E4A, 0x3E3E4A, 0x41414A, 0x4A4A4A, 0x4A4A4A, 0x4A4A4A, 0x4A4A4A, 0x4A4A4A, 0x4A4A4A, 0x494949, 0x414149,
+        0x333333, 0x333333, 0x333333, 0x39393E, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x545455,
+        0x333333, 0x333333, 0x353537, 0x434353, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x515155, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555,
+        0x333333, 0x333333, 0x40404D, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x4D4D55, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555,
+        0x333333, 0x3B3B42, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x494955, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555,
+        0x36363A, 0x444454, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x454555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555,
+    },
+    {
+        0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377,
+        0x223377, 0x223377, 0x323E78, 0x60607D, 0x56597C, 0x223377, 0x223377, 0x223377, 0x223377, 0x263679, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377,
+        0x223977, 0x223977, 0x314477, 0xCFB57A, 0xC6AE76, 0x4A5271, 0x223977, 0x223977, 0x223977, 0x7A81A2, 0xAAAABB, 0x536290, 0x223977, 0x253B78, 0x596492, 0x666F99, 0x5E6995, 0x223977, 0x223977, 0x223977,
+        0x2B4B7C, 0x224477, 0x224477, 0xB99F77, 0xCCAA77, 0x646766, 0x224477, 0x224477, 0x224477, 0x7A85A2, 0xAAAABB, 0x667BA4, 0x2B4C80, 0x6B7896, 0xA5A5B6, 0xAAAABB, 0x9098B3, 0x2B4C80, 0x224477, 0x224477,
+        0x637799, 0x808FB4, 0x576FA4, 0x959298, 0xC9A978, 0x7B6F69, 0x2A4A8A, 0x606C88, 0x304D87, 0x7782A7, 0xA4A4BB, 0x869DC6, 0x3C5E93, 0x808AA0, 0xA7A7B8, 0xAAAABB, 0x92A2C3, 0x4A6499, 0x29498A, 0x9A9AAB,
+        0x557799, 0x6A8AB7, 0x7A99CF, 0x7795C9, 0x6A7B96, 0x8B7D67, 0x224488, 0xCCB077, 0x697389, 0x6F7BA4, 0x9999B5, 0x939FBF, 0x7E8FA7, 0x979CA6, 0x9E9EBB, 0x9F9FBB, 0x869CC0, 0x859F9C, 0x455D92, 0x9A9AB1,
+        0x556C99, 0x5E78A7, 0x7799CC, 0x7799CC, 0x58769D, 0x908266, 0x68577A, 0xCDA276, 0x737B88, 0x7F899B, 0x9999AA, 0xA4A4B5, 0xAAAABB, 0x8A8DA1, 0xA2A29F, 0xAAAAA7, 0xA0A69F, 0xA7AD85, 0xADA291, 0xAA9E8D,
+        0x55668B, 0x56678C, 0x7698CA, 0x7799CC, 0x5E749F, 0x83755E, 0x9C615E, 0xAC805E, 0x747F78, 0x8E9C99, 0x9999AA, 0x9797B1, 0x9399AB, 0x8B8B9B, 0xA0A088, 0xADAD91, 0xB6AB81, 0xBBAA77, 0xBBAA77, 0xBBAA77,
+        0x556688, 0x556688, 0x6A6F69, 0x7C7C67, 0x697585, 0x746E66, 0x875A4E, 0x976F55, 0xA58A5C, 0xA3947E, 0x9999AA, 0x9696A7, 0x9397A2, 0x8E8E96, 0x9D9D7D, 0xAAAA88, 0xB8A37A, 0xBBA777, 0xBBA777, 0xBBA777,
+        0x556688, 0x556688, 0x6C7577, 0x7D7D66, 0x677377, 0x646968, 0x595249, 0x756B59, 0xC1A26C, 0xAA9784, 0x8888AA, 0x8B8BA8, 0x868D9E, 0x8A8A91, 0x9C9C7F, 0xA6A486, 0xBB9970, 0xBB9977, 0xBB9977, 0xBB9977,
+        0x506688, 0x446688, 0x546C80, 0x777766, 0x6F756A, 0x4D5775, 0x464555, 0x444455, 0x444455, 0x4C4C57, 0x555555, 0x555555, 0x565657, 0x737375, 0x929275, 0xA29973, 0xBB9967, 0xBB9969, 0xBB9969, 0xBB9969,
+        0x446688, 0x446688, 0x446588, 0x74755D, 0x6A6A55, 0x484D5F, 0x474755, 0x494955, 0x4A4A55, 0x4C4C55, 0x4D4D55, 0x4D4D55, 0x4D4D55, 0x4D4D55, 0x61615E, 0x918264, 0xBB9966, 0xBB9966, 0xBB9966, 0xBB9966,
+        0x486A8E, 0x446588, 0x445988, 0x616662, 0x5D5D55, 0x555555, 0x555555, 0x555555, 0x555555, 0x535355, 0x444455, 0x444455, 0x444455, 0x444455, 0x444455, 0x8B8061, 0xB69966, 0xBB9966, 0xBB9966, 0xBB9966,
+        0x5576A2, 0x445888, 0x445587, 0x4F5868, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x454555, 0x444455, 0x444455, 0x444455, 0x444455, 0xA28B65, 0xAC9966, 0xB89966, 0xB89966, 0xBA9A67,
+        0x6282B5, 0x445587, 0x465575, 0x545557, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x484855, 0x444455, 0x444455, 0x444455, 0x4F4C55, 0xAA8860, 0xAA9366, 0xAA9966, 0xAA9966, 0xB5A06A,
+        0x6688BB, 0x4F658C, 0x52555C, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x585858, 0x59595B, 0x4F4F57, 0x4A4A55, 0x4A4A55, 0x4C4C55, 0x665D55, 0xAA8855, 0xAA8A62, 0xAA9966, 0xAA9966, 0xB8A266,
+        0x58647D, 0x5D6473, 0x5E5E63, 0x626267, 0x5E5E67, 0x61616A, 0x5E5F6B, 0x5A5F75, 0x555D77, 0x4F5B7A, 0x515767, 0x555555, 0x555555, 0x555555, 0x555555, 0x786A55, 0xA8875B, 0xAA8B66, 0xAF9066, 0xBB9966,
+        0x41527A, 0x3E527F, 0x3E5588, 0x3A558F, 0x395591, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x43567D, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x635E56, 0xA1825E, 0xB69465, 0xBB9966,
+        0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x3E5687, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x5E5B55, 0x776C5B, 0x85755D,
+        0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x395590, 0x555556, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555,
+    },
+    {
+        0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x676958, 0x717155, 0x717155,
+        0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x2B3C75, 0x40516F, 0x556468, 0x666655, 0x666655, 0x666655,
+        0x223977, 0x223977, 0x223977, 0x223977, 0x223977, 0x223977, 0x223977, 0x223977, 0x414E71, 0x797C72, 0x626C7F, 0x223977, 0x223977, 0x394D71, 0x667766, 0x667766, 0x667261, 0x666655, 0x666655, 0x666655,
+        0x224477, 0x224477, 0x224477, 0x224477, 0x224477, 0x334E74, 0x64747C, 0x39557A, 0x4D5E6F, 0x848471, 0x8D9385, 0x224477, 0x224477, 0x3D596F, 0x667766, 0x667766, 0x666F5E, 0x666655, 0x666655, 0x666655,
+        0x224488, 0x334E83, 0x415885, 0x534D6F, 0x646E8D, 0x57707E, 0x95957E, 0x66748C, 0x48596F, 0x7D7D64, 0x858B85, 0x284381, 0x2E447F, 0x3C5E6F, 0x557755, 0x557755, 0x616B55, 0x666655, 0x666655, 0x666655,
+        0x224488, 0x515373, 0x857D78, 0x715665, 0x806F74, 0x799577, 0x88886E, 0x8C8674, 0x71716B, 0x777760, 0x858B7A, 0x504462, 0x515775, 0x56746C, 0x557755, 0x557755, 0x646855, 0x666655, 0x666655, 0x666655,
+        0x284A8A, 0x45446E, 0x9B8267, 0x55556A, 0x837276, 0x698E69, 0x808167, 0x8B8160, 0x777366, 0x777760, 0x8E9079, 0x56485E, 0x4D5771, 0x556C65, 0x556E55, 0x566F55, 0x666655, 0x666655, 0x666655, 0x666655,
+        0x5F74A6, 0x2F467B, 0x737865, 0x555B68, 0x744D50, 0x6A8162, 0x7B896F, 0x7B745D, 0x7F745A, 0x726E5B, 0x806557, 0x805151, 0x6E6D67, 0x586657, 0x556655, 0x596653, 0x66664F, 0x66664F, 0x666655, 0x656956,
+        0x6A7AAC, 0x34496E, 0x426B93, 0x3F4152, 0x5D4850, 0x5D948B, 0x688771, 0x5F6452, 0x559F3E, 0x695F4B, 0x6B3636, 0x9E5250, 0x5B5F64, 0x4F664F, 0x526652, 0x5A634D, 0x606044, 0x606044, 0x66664A, 0x5F6951,
+        0x6F88BB, 0x54B455, 0x338433, 0x333333, 0x364758, 0x4488BB, 0x376A9E, 0x414C41, 0x4B6146, 0x615848, 0x6B3636, 0x9F5551, 0x5E5653, 0x446644, 0x456645, 0x505B45, 0x555544, 0x555544, 0x5E5E44, 0x586652,
+        0x6688BB, 0x438373, 0x287034, 0x363636, 0x333333, 0x333333, 0x333333, 0x39393A, 0x464649, 0x494752, 0x52414D, 0x504553, 0x444A50, 0x446644, 0x446644, 0x535744, 0x555544, 0x555544, 0x545845, 0x4D664D,
+        0x6688BB, 0x5E81A4, 0x52534C, 0x515151, 0x3A3A3A, 0x333333, 0x333333, 0x333333, 0x333333, 0x343435, 0x3A3A40, 0x41414C, 0x505254, 0x505A50, 0x4B5F4A, 0x555545, 0x555544, 0x555544, 0x4E5E45, 0x446644,
+        0x6688B0, 0x6688B0, 0x52555C, 0x4A4A55, 0x444454, 0x393940, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x383839, 0x444446, 0x4F4F51, 0x555555, 0x555551, 0x55554B, 0x475849, 0x446345,
+        0x667DAA, 0x667DAA, 0x525B78, 0x444455, 0x444455, 0x444455, 0x3C3C45, 0x333334, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x343434, 0x3B3B3D, 0x464649, 0x4E4E52, 0x444455, 0x444455,
+        0x6677AA, 0x6677AA, 0x5E6A95, 0x444455, 0x444455, 0x444455, 0x444455, 0x41414A, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x343944, 0x3B3C45, 0x42424E,
+        0x5577AA, 0x5577AA, 0x5577AA, 0x45485C, 0x444455, 0x464657, 0x4B4C59, 0x3A4F7C, 0x2D3C5B, 0x323233, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x334872, 0x335393, 0x32456E,
+        0x5577AA, 0x5577AA, 0x5577AA, 0x4B5978, 0x4B4B59, 0x464D63, 0x36528C, 0x335599, 0x335599, 0x2F436C, 0x313133, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x33518E, 0x335599, 0x335599,
+        0x5577AA, 0x5577AA, 0x536B94, 0x4E5263, 0x3F4D6F, 0x335597, 0x335599, 0x335599, 0x335599, 0x335599, 0x30487B, 0x2E2F34, 0x333333, 0x333333, 0x333333, 0x333333, 0x33373E, 0x335599, 0x335599, 0x335599,
+        0x5473A3, 0x4F5C77, 0x494C5C, 0x394F80, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x314D87, 0x2C303D, 0x333334, 0x333333, 0x333333, 0x33405B, 0x335599, 0x335599, 0x335599,
+        0x4E5160, 0x444B61, 0x355390, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x335599, 0x325190, 0x2A3142, 0x323235, 0x333333, 0x334871, 0x335599, 0x335599, 0x335599,
+    },
+    {
+        0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x4A547F, 0x696D85, 0x7A7A88, 0x7A7A88,
+        0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x253376, 0x223377, 0x223377, 0x223377, 0x223377, 0x223377, 0x707187, 0x777788, 0x777788, 0x777788,
+        0x223977, 0x223977, 0x223977, 0x243A77, 0x223977, 0x223977, 0x223977, 0x223977, 0x333C72, 0x71444E, 0x683941, 0x4B4F6B, 0x223977, 0x223977, 0x223977, 0x293D78, 0x777788, 0x777788, 0x777788, 0x777788,
+        0x244577, 0x224477, 0x334F76, 0x7B7C69, 0x455970, 0x224477, 0x224477, 0x224477, 0x31446F, 0x784343, 0x6B403A, 0x696961, 0x224477, 0x224477, 0x224477, 0x37517B, 0x777788, 0x777788, 0x777788, 0x777788,
+        0x717467, 0x354F80, 0x224488, 0x767761, 0x626964, 0x294885, 0x224488, 0x224488, 0x31447D, 0x724040, 0x774C41, 0x756A69, 0x334E87, 0x2F4D85, 0x244587, 0x485B88, 0x777788, 0x777788, 0x777788, 0x777788,
+        0x6E6F5C, 0x435570, 0x224488, 0x757266, 0x726D55, 0x646869, 0x374477, 0x3F5382, 0x40557B, 0x713F3F, 0x6D3D3A, 0x747079, 0x4E5F85, 0x6F746B, 0x6A5362, 0x74616D, 0x777788, 0x777788, 0x777788, 0x777788,
+        0x6D6F5A, 0x6C695E, 0x364E7F, 0x887A60, 0x877154, 0x756A5B, 0x3A4F78, 0x43557D, 0x415A7D, 0x764242, 0x74423E, 0x706A64, 0x4A5A7B, 0x68766C, 0x71585A, 0x6E6775, 0x777785, 0x777787, 0x777788, 0x777788,
+        0x525C55, 0x756548, 0x47526B, 0x85735B, 0x796846, 0x776644, 0x51507E, 0x545776, 0x324268, 0x774343, 0x774C3D, 0x665C58, 0x3B547A, 0x5A8A89, 0x665D5E, 0x707077, 0x717177, 0x747480, 0x777785, 0x777785,
+        0x353E61, 0x464344, 0x3D4053, 0x675D50, 0x7E5E45, 0x74413A, 0x623639, 0x514D55, 0x404048, 0x744141, 0x74473D, 0x5C5860, 0x40604D, 0x4AD45F, 0x3C626C, 0x666677, 0x666677, 0x6C6C77, 0x747477, 0x747477,
+        0x303030, 0x353539, 0x46464C, 0x58524F, 0x6C563E, 0x6D5237, 0x5C3634, 0x4E464B, 0x474753, 0x50444E, 0x554347, 0x49555C, 0x363639, 0x333334, 0x414148, 0x666677, 0x666677, 0x666677, 0x666677, 0x666677,
+        0x333333, 0x333333, 0x353537, 0x42B047, 0x49CB4D, 0x336B3A, 0x386541, 0x535354, 0x44444C, 0x3A3A40, 0x336FAB, 0x4DAAEE, 0x334455, 0x36363C, 0x545461, 0x666677, 0x666677, 0x666677, 0x666677, 0x666677,
+        0x333333, 0x333334, 0x338833, 0x3ADD3A, 0x41DD41, 0x39B139, 0x434A45, 0x3A3A3B, 0x333333, 0x334455, 0x336699, 0x407399, 0x3C6694, 0x444454, 0x5B5B6C, 0x666677, 0x666677, 0x666677, 0x666677, 0x666677,
+        0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333334, 0x333334, 0x333333, 0x4A3939, 0x333333, 0x343434, 0x444444, 0x555555, 0x545455, 0x636371, 0x666677, 0x666677, 0x666677, 0x666677, 0x666677,
+        0x333333, 0x333334, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x883333, 0xF94D4D, 0x6E3535, 0x4B4B4B, 0x555555, 0x555555, 0x555555, 0x666677, 0x666677, 0x666677, 0x666677, 0x666677, 0x666677,
+        0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x883333, 0xFF3333, 0xFF4D4D, 0xFA3434, 0x844C4C, 0x555555, 0x555555, 0x555555, 0x58585B, 0x60606B, 0x666676, 0x666677, 0x666677, 0x717177,
+        0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x883333, 0xFF3333, 0xFF3333, 0xFF4D4D, 0xFF3333, 0xFA3434, 0x844C4C, 0x555555, 0x555555, 0x555555, 0x555555, 0x575759, 0x5E5E68, 0x656575, 0x4E4E5E,
+        0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x553333, 0x873233, 0xFF3333, 0xFF4444, 0xFF3333, 0xFF3333, 0xFA3434, 0x794C4D, 0x555555, 0x555555, 0x555555, 0x555555, 0x555555, 0x515157, 0x444455,
+        0x333333, 0x333333, 0x333333, 0x333333, 0x333333, 0x302B2E, 0xC82F2F, 0xFF3333, 0xFF3333, 0xFF3333, 0xFF3333, 0xC63C4F, 0x3B4F86, 0x464B59, 0x535355, 0x555555, 0x555555, 0x555555, 0x4F4F55, 0x444455,
+        0x333333, 0x333333, 0x333333, 0x323234, 0x292B34, 0x3D426F, 0xDD3944, 0xFF3333, 0xFF3333, 0xFF3333, 0xC63C4F, 0x395496, 0x335599, 0x335497, 0x3C4A6B, 0x4E4E53, 0x555555, 0x555555, 0x4F4F55, 0x444455,
+        0x333333, 0x333333, 0x303033, 0x262A35, 0x2F4B85, 0x335599, 0x445291, 0xDD3944, 0xFF3333, 0xC63C4F, 0x395496, 0x335599, 0x335599, 0x335599, 0x335599, 0x364F82, 0x454854, 0x535355, 0x4F4F55, 0x444455,
+    },
+};
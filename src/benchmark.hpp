@@ -0,0 +1,117 @@
+#pragma once
+#include "render3d.hpp"
+#include "rasterizer.hpp"
+#include "resolution.hpp"
+
+// Seeded benchmark scenes: scripted camera paths through the city, rendered
+// on the calling core with the game's pipeline at full resolution. The last
+// frame of each path is compared with a stored reference image (averaged
+// over cells, so small differences in float math between builds pass) and
+// the times with a stored baseline.
+
+constexpr int BENCHMARK_SCENES = 4;
+constexpr int BENCHMARK_FRAMES = 8;               // Frames per camera path
+constexpr int BENCHMARK_CELL_SIZE = 6;            // Pixels per reference cell side
+constexpr int BENCHMARK_CELLS = SCREEN_WIDTH / BENCHMARK_CELL_SIZE;  // Cells per side
+constexpr int BENCHMARK_CELL_TOLERANCE = 24;      // Max channel difference of a cell (0-255)
+constexpr int BENCHMARK_MAX_BAD_CELLS = 8;        // Cells allowed over the tolerance (2%)
+
+// Built for the host test (tests/host): times are checked against the host
+// baselines, with more tolerance as the host clock is shared
+#ifndef BENCHMARK_HOST
+#define BENCHMARK_HOST 0
+#endif
+#if BENCHMARK_HOST
+constexpr int BENCHMARK_TIME_TOLERANCE_PCT = 50;  // Allowed slowdown over the baseline
+#else
+constexpr int BENCHMARK_TIME_TOLERANCE_PCT = 10;  // Allowed slowdown over the baseline
+#endif
+
+struct BenchmarkResult {
+    uint32_t build_us;   // Scene building and billboards, summed over the path
+    uint32_t raster_us;  // Rasterization, summed over the path
+    uint32_t triangles;  // In the last frame
+    int max_error;       // Worst cell difference from the reference
+    int bad_cells;       // Cells over BENCHMARK_CELL_TOLERANCE
+    bool image_ok;
+    bool time_ok;        // Always true while the scene has no baseline
+};
+
+// Render a scene's camera path into fb, leaving its last frame there
+// (re-seeds the city and clears the depth buffers)
+void benchmark_render_scene(int scene, color_t* fb, BenchmarkResult& result);
+
+// Average a frame over BENCHMARK_CELLS x BENCHMARK_CELLS cells, as 0xRRGGBB
+void benchmark_reduce_image(const color_t* fb, uint32_t* cells);
+
+// Render and check every scene, returns true if all of them pass
+// (Core 1 must be idle: the rasterizer runs on the calling core)
+bool benchmark_run(color_t* fb, BenchmarkResult results[BENCHMARK_SCENES]);
+
+// Dynamic resolution over longer walks along the scenes' paths: per-frame
+// raster times with the controller adapting against target_us, or with the
+// resolution held at 120 (adapt = false). The paths are heavy enough for
+// the controller when target_us is about their mean full-resolution time.
+constexpr int BENCHMARK_RESOLUTION_FRAMES = 120;  // Frames per scene
+
+struct ResolutionRun {
+    uint32_t mean_us;       // Raster time per frame
+    uint32_t deviation_us;  // Standard deviation of it
+    uint32_t max_us;
+    uint32_t over_target;   // Frames slower than target_us
+    int smallest;           // Smallest viewport side used
+};
+
+void benchmark_resolution(color_t* fb, uint32_t target_us, bool adapt, ResolutionRun& result);
+
+// Rasterizer backends side by side on the last frame of each scene: the
+// captured triangle list is re-rasterized with every backend
+constexpr int BENCHMARK_BACKEND_RUNS = 3;  // Fastest of this many renders per backend
+
+struct BackendComparison {
+    uint32_t triangles;
+    uint32_t raster_us[RASTER_BACKEND_COUNT];
+    bool identical;   // Colour and depth match the edge backend's bit for bit
+    int max_error;    // Worst cell difference from the edge backend
+};
+
+// Render each scene, then time its last frame with every backend
+// (Core 1 must be idle; the selected backend is restored afterwards)
+void benchmark_compare_backends(color_t* fb, BackendComparison results[BENCHMARK_SCENES]);
+
+// Synthetic rasterizer workloads, for scaling curves: right triangles with
+// legs of `leg` pixels at random positions, enough of them to cover the
+// screen `overdraw` times (up to MAX_TRIANGLES), one depth per triangle
+enum StressOrder : uint8_t {
+    STRESS_RANDOM,          // Random depths
+    STRESS_FRONT_TO_BACK,   // Nearest first, so later triangles fail the depth test
+    STRESS_BACK_TO_FRONT,   // Farthest first, so every covered pixel is written
+};
+
+enum StressShading : uint8_t {
+    STRESS_FLAT,
+    STRESS_GOURAUD,    // Three vertex colours
+    STRESS_TEXTURED,   // TEXTURE_BRICK, one texture tile per triangle
+};
+
+struct StressWorkload {
+    uint8_t leg;        // 1 (3 pixels) to SCREEN_WIDTH - 1 (half the screen)
+    uint8_t overdraw;   // Average layers per pixel
+    StressShading shading;
+    StressOrder order;
+};
+
+struct StressResult {
+    uint32_t triangles;
+    uint32_t pixels;           // Pixels inside the triangles (depth tested)
+    uint32_t time_us;          // Rasterizing, without the frame clear
+    uint32_t ns_per_triangle;
+    uint32_t ns_per_pixel;
+};
+
+// Rasterize a workload into fb on the calling core
+void benchmark_stress(const StressWorkload& workload, color_t* fb, StressResult& result);
+
+// Sweep of triangle size, depth order, shading and overdraw
+constexpr int BENCHMARK_STRESS_SWEEP = 13;
+extern const StressWorkload benchmark_stress_sweep[BENCHMARK_STRESS_SWEEP];
@@ -1,18 +1,162 @@
 #include "city.hpp"
+#include "spatial.hpp"
+#include "texture.hpp"
+#include "mesh.hpp"
+#include "meshes.hpp"
 #include <cmath>
 #include <algorithm>
 
 using namespace picosystem;
 
 // Global arrays
-Building buildings[MAX_BUILDINGS];
+BuildingStore buildings;
 Gem3D gems_3d[MAX_GEMS_3D];
 int active_building_count = 0;
+int active_gem_count = 0;
 
 // City state
 uint32_t city_seed = 12345;
-int city_chunk_left = 0;
-int city_chunk_right = 0;
+int city_chunk_cx = 0;
+int city_chunk_cz = 0;
+int city_window_radius = CITY_MAX_WINDOW_RADIUS;
+float city_draw_distance = CITY_DRAW_DISTANCE;
+
+// Chunk occupying a window slot. Its buildings / gems are the first
+// building_count / gem_count entries of the slot's slabs.
+struct ChunkSlab {
+    int16_t cx, cz;
+    bool live;
+    uint8_t building_count;
+    uint8_t gem_count;
+};
+
+static ChunkSlab chunk_slabs[CITY_WINDOW_SLOTS];
+
+// A chunk being generated a few tiles at a time. Its contents are staged
+// here, then copied to its window slot when it goes live.
+struct ChunkStream {
+    int16_t cx, cz;
+    ChunkState state;
+    uint8_t next_tile;        // Next tile to generate
+    uint8_t building_count;
+    uint8_t gem_count;
+    Building buildings[MAX_BUILDINGS_PER_CHUNK];
+    Gem3D gems[MAX_GEMS_PER_CHUNK];
+};
+
+static ChunkStream chunk_streams[CITY_STREAM_SLOTS];
+static ChunkStream scratch_stream;  // For synchronous generation
+
+// LRU cache of recently unloaded chunks (state CHUNK_READY when occupied),
+// so coming back to one is a copy instead of a regeneration
+static ChunkStream chunk_cache[CITY_CHUNK_CACHE_SLOTS];
+static uint32_t chunk_cache_last_used[CITY_CHUNK_CACHE_SLOTS];
+static uint32_t chunk_cache_clock = 0;
+static_assert(CITY_CHUNK_CACHE_SLOTS >= 1, "chunk cache needs at least one slot");
+
+// Collected-gem bitsets (bit i = gem i of the chunk), direct-mapped by chunk.
+// Survives unloading and cache eviction for any CITY_GEM_STATE_SIDE square of chunks.
+struct GemState {
+    int16_t cx, cz;
+    uint16_t collected;
+};
+static GemState gem_state[CITY_GEM_STATE_CHUNKS];
+static_assert(MAX_GEMS_PER_CHUNK <= 16, "collected-gem bitset is 16 bits");
+
+// Gem sprite cache: run-length spans of the diamond for each size, shared by
+// all gem types, with each type's colours pre-converted. Gems closer than
+// GEM_SPRITE_MAX_SIZE allows (up to 240 px half-height) are drawn uncached.
+static const int GEM_SPRITE_MAX_SIZE = 16;     // Half-height in pixels
+static const uint8_t GEM_SPAN_HIGHLIGHT = 0x80;  // Flag in GemSpan::length
+
+struct GemSpan {
+    int8_t dy, dx;     // First pixel, relative to the gem centre
+    uint8_t length;    // Pixels, | GEM_SPAN_HIGHLIGHT for the highlight colour
+};
+
+// Spans in a diamond of half-height `size`: rows above the centre wider than
+// the 3-pixel highlight split into body / highlight / body
+static constexpr int gem_sprite_spans(int size) {
+    int split_rows = size > 2 ? size - 2 : 0;
+    return 3 * split_rows + (size - split_rows) + (size + 1);
+}
+
+static constexpr int gem_sprite_total_spans() {
+    int total = 0;
+    for (int size = 1; size <= GEM_SPRITE_MAX_SIZE; size++) total += gem_sprite_spans(size);
+    return total;
+}
+
+static GemSpan gem_spans[gem_sprite_total_spans()];
+static uint16_t gem_size_first[GEM_SPRITE_MAX_SIZE + 1];  // First span of size s at [s - 1], end at [s]
+static color_t gem_sprite_colors[3][2];                  // Body / highlight per gem type
+
+static void gem_sprites_init() {
+    static const uint8_t gem_colors[3][3] = {
+        {255, 50, 50},   // Red
+        {50, 255, 50},   // Green
+        {50, 150, 255}   // Blue
+    };
+    for (int type = 0; type < 3; type++) {
+        uint8_t r = gem_colors[type][0], g = gem_colors[type][1], b = gem_colors[type][2];
+        gem_sprite_colors[type][0] = rgb_to_color(r, g, b);
+        gem_sprite_colors[type][1] = rgb_to_color(std::min(255, r + 50), std::min(255, g + 50), std::min(255, b + 50));
+    }
+
+    int count = 0;
+    for (int size = 1; size <= GEM_SPRITE_MAX_SIZE; size++) {
+        gem_size_first[size - 1] = count;
+        for (int dy = -size; dy <= size; dy++) {
+            int width = size - abs(dy);
+            if (dy < 0 && width >= 2) {
+                gem_spans[count++] = {(int8_t)dy, (int8_t)-width, (uint8_t)(width - 1)};
+                gem_spans[count++] = {(int8_t)dy, -1, (uint8_t)(3 | GEM_SPAN_HIGHLIGHT)};
+                gem_spans[count++] = {(int8_t)dy, 2, (uint8_t)(width - 1)};
+            } else {
+                uint8_t flags = dy < 0 ? GEM_SPAN_HIGHLIGHT : 0;
+                gem_spans[count++] = {(int8_t)dy, (int8_t)-width, (uint8_t)((2 * width + 1) | flags)};
+            }
+        }
+    }
+    gem_size_first[GEM_SPRITE_MAX_SIZE] = count;
+}
+
+// Camera position and direction of travel (one axis) from the last update (for prefetch)
+static float stream_last_camera_x = 0.0f;
+static float stream_last_camera_z = 0.0f;
+static int stream_direction_x = 1;
+static int stream_direction_z = 0;
+
+// Tile index (tz * CITY_CHUNK_WIDTH + tx) of each building site, in tile order
+static uint8_t building_site_tile[CITY_BUILDING_SITES];
+
+int city_collision_visits = 0;
+int city_gem_visits = 0;
+int city_chunks_drawn = 0;
+int city_buildings_drawn = 0;
+int city_buildings_occluded = 0;
+int city_gems_occluded = 0;
+
+// Building slots drawn into this frame's occlusion map, nearest first
+static int16_t occluder_slots[CITY_MAX_OCCLUDERS];
+static int occluder_count = 0;
+
+// Gem billboards reach this far from the gem in world units (size plus bob)
+static const float GEM_OCCLUSION_HALF_EXTENT = 3.5f;
+
+// Spatial hashes over building / gem slots (kept in sync by generate/remove)
+static SpatialHash building_grid;
+static int16_t building_grid_next[MAX_BUILDINGS];
+static uint8_t building_grid_bucket[MAX_BUILDINGS];
+static SpatialHash gem_grid;
+static int16_t gem_grid_next[MAX_GEMS_3D];
+static uint8_t gem_grid_bucket[MAX_GEMS_3D];
+
+// Buildings are hashed by centre; queries are widened by the largest half-size
+static const float BUILDING_MAX_HALF_EXTENT = 1.25f;
+
+// Most candidates a collision query can return (a few cells' worth of buildings)
+static const int MAX_QUERY_CANDIDATES = 64;
 
 // Building color palettes
 static const uint8_t building_colors[][3] = {
@@ -24,6 +168,9 @@ static const uint8_t building_colors[][3] = {
     {140, 140, 160},  // Purple-ish
 };
 
+// Buildings of this colour get brick walls (TEXTURE_BRICK is tinted to match)
+static const int BRICK_BUILDING_COLOR = 0;
+
 static const uint8_t roof_colors[][3] = {
     {120, 60, 60},    // Dark red
     {60, 80, 120},    // Dark blue
@@ -38,248 +185,791 @@ uint32_t city_random(uint32_t& seed) {
     return (seed >> 16) & 0x7FFF;
 }
 
+// Baked prop meshes (data stays in flash); props are skipped if either
+// blob failed to load (bad magic, or more vertices than MESH_MAX_VERTICES)
+static Mesh tree_mesh;
+static Mesh sleigh_mesh;
+static bool props_loaded = false;
+
+// Trees may stand on the pavement corner tiles, one in PROP_TREE_CHANCE of them
+static const uint8_t prop_tree_tiles[4] = {
+    1 * CITY_CHUNK_WIDTH + 1, 1 * CITY_CHUNK_WIDTH + CITY_CHUNK_WIDTH - 2,
+    (CITY_CHUNK_WIDTH - 2) * CITY_CHUNK_WIDTH + 1, (CITY_CHUNK_WIDTH - 2) * CITY_CHUNK_WIDTH + CITY_CHUNK_WIDTH - 2,
+};
+static const uint32_t PROP_TREE_CHANCE = 3;
+
+// The sleigh is parked on the street by the start, pointing along z
+static const float SLEIGH_X = 1.0f, SLEIGH_Z = 11.0f;
+
+int city_props_drawn = 0;
+
+// Rings of tiles in from the chunk edge: 0 = street, 1 = pavement, 2 = building sites
+static inline int tile_ring(int tx, int tz) {
+    return std::min(std::min(tx, tz), std::min(CITY_CHUNK_WIDTH - 1 - tx, CITY_CHUNK_WIDTH - 1 - tz));
+}
+
+void city_set_view_range(int window_radius, float draw_distance) {
+    city_window_radius = std::min(std::max(window_radius, 1), CITY_MAX_WINDOW_RADIUS);
+    city_draw_distance = draw_distance;
+    render3d_set_fog(draw_distance * CITY_FOG_START, draw_distance);
+}
+
 void city_init(uint32_t seed) {
     city_seed = seed;
-
-    for (int i = 0; i < MAX_BUILDINGS; i++) {
-        buildings[i].active = false;
+    gem_sprites_init();
+    render3d_set_fog(city_draw_distance * CITY_FOG_START, city_draw_distance);
+    props_loaded = mesh_load(mesh_tree_data, tree_mesh);
+    props_loaded = mesh_load(mesh_sleigh_data, sleigh_mesh) && props_loaded;
+
+    int site = 0;
+    for (int tile = 0; tile < CITY_CHUNK_WIDTH * CITY_CHUNK_WIDTH; tile++) {
+        if (tile_ring(tile % CITY_CHUNK_WIDTH, tile / CITY_CHUNK_WIDTH) == 2) {
+            building_site_tile[site++] = tile;
+        }
     }
 
-    for (int i = 0; i < MAX_GEMS_3D; i++) {
-        gems_3d[i].active = false;
+    spatial_init(building_grid, building_grid_next, building_grid_bucket, MAX_BUILDINGS);
+    spatial_init(gem_grid, gem_grid_next, gem_grid_bucket, MAX_GEMS_3D);
+
+    for (int i = 0; i < CITY_WINDOW_SLOTS; i++) {
+        chunk_slabs[i].live = false;
+    }
+    for (int i = 0; i < CITY_STREAM_SLOTS; i++) {
+        chunk_streams[i].state = CHUNK_FREE;
     }
+    for (int i = 0; i < CITY_CHUNK_CACHE_SLOTS; i++) {
+        chunk_cache[i].state = CHUNK_FREE;
+    }
+    for (int i = 0; i < CITY_GEM_STATE_CHUNKS; i++) {
+        gem_state[i].cx = INT16_MIN;
+        gem_state[i].cz = INT16_MIN;
+        gem_state[i].collected = 0;
+    }
+    chunk_cache_clock = 0;
+    stream_last_camera_x = 0.0f;
+    stream_last_camera_z = 0.0f;
+    stream_direction_x = 1;
+    stream_direction_z = 0;
 
     active_building_count = 0;
-    city_chunk_left = -1;
-    city_chunk_right = 2;
+    active_gem_count = 0;
+    city_chunk_cx = 0;
+    city_chunk_cz = 0;
 
-    for (int c = city_chunk_left; c <= city_chunk_right; c++) {
-        city_generate_chunk(c);
+    for (int cz = -city_window_radius; cz <= city_window_radius; cz++) {
+        for (int cx = -city_window_radius; cx <= city_window_radius; cx++) {
+            city_generate_chunk(cx, cz);
+        }
     }
 }
 
-static int find_free_building_slot() {
-    for (int i = 0; i < MAX_BUILDINGS; i++) {
-        if (!buildings[i].active) return i;
+// Known answers for the counter-based generator. Checked by every compiler
+// that builds this file, so host and device builds must generate the same city.
+static_assert(city_hash(12345, 0, 0, 0) == 0x5960420Cu, "city_hash is not deterministic");
+static_assert(city_hash(12345, -3, 7, 20) == 0x920EF872u, "city_hash is not deterministic");
+static_assert(city_random_at(1, 2, 3, 4) == 4911, "city_random_at is not deterministic");
+static_assert(city_chunk_key(-3, 5) == (int32_t)0x6F64FF72u, "city_chunk_key is not deterministic");
+
+// Attribute values shared by the per-tile and batch generators
+static inline uint32_t tile_attr(int32_t key, int tile, uint32_t attribute) {
+    return city_random_at(city_seed, key, tile, attribute);
+}
+
+// World-space centre of a tile
+static inline float tile_world_x(int cx, int tile) {
+    return cx * CITY_CHUNK_SIZE + (tile % CITY_CHUNK_WIDTH + 0.5f) * TILE_SIZE_3D;
+}
+
+static inline float tile_world_z(int cz, int tile) {
+    return cz * CITY_CHUNK_SIZE + (tile / CITY_CHUNK_WIDTH + 0.5f) * TILE_SIZE_3D;
+}
+
+// Chunk-local fixed-point centre of a tile along one axis
+static inline int16_t tile_local_fixed(int t) {
+    return (int16_t)((2 * t + 1) * CITY_FIXED_ONE * (int32_t)TILE_SIZE_3D / 2);
+}
+
+// Sizes: 1.5 to 2.49 units wide / deep, 2 to 9 units tall
+static inline int16_t building_half_extent(uint32_t attr) {
+    return (int16_t)((150 + attr % 100) * CITY_FIXED_ONE / 200);
+}
+
+static inline int16_t building_height(uint32_t attr) {
+    return (int16_t)((2 + attr % 8) * CITY_FIXED_ONE);
+}
+
+void city_generate_building_params(int cx, int cz, ChunkBuildingParams& out) {
+    int32_t key = city_chunk_key(cx, cz);
+    for (int i = 0; i < CITY_BUILDING_SITES; i++) {
+        int tile = building_site_tile[i];
+        out.present[i] = tile_attr(key, tile, CITY_ATTR_BUILDING_PRESENT) % 5 < 3;
+        out.x[i] = tile_local_fixed(tile % CITY_CHUNK_WIDTH);
+        out.z[i] = tile_local_fixed(tile / CITY_CHUNK_WIDTH);
+        out.half_width[i] = building_half_extent(tile_attr(key, tile, CITY_ATTR_BUILDING_WIDTH));
+        out.half_depth[i] = building_half_extent(tile_attr(key, tile, CITY_ATTR_BUILDING_DEPTH));
+        out.height[i] = building_height(tile_attr(key, tile, CITY_ATTR_BUILDING_HEIGHT));
+        out.color[i] = tile_attr(key, tile, CITY_ATTR_BUILDING_COLOR) % 6;
     }
-    return -1;
 }
 
-static int find_free_gem_slot() {
-    for (int i = 0; i < MAX_GEMS_3D; i++) {
-        if (!gems_3d[i].active) return i;
+static void stream_begin(ChunkStream& stream, int cx, int cz) {
+    stream.cx = cx;
+    stream.cz = cz;
+    stream.state = CHUNK_REQUESTED;
+    stream.next_tile = 0;
+    stream.building_count = 0;
+    stream.gem_count = 0;
+}
+
+// Generate the gem for one street tile, if it has one
+static void generate_tile_gem(ChunkStream& stream, int tile) {
+    int32_t key = city_chunk_key(stream.cx, stream.cz);
+    if (stream.gem_count >= MAX_GEMS_PER_CHUNK) return;
+    if (tile_attr(key, tile, CITY_ATTR_GEM_PRESENT) % 10 != 0) return;
+
+    Gem3D& g = stream.gems[stream.gem_count++];
+    g.x = tile_world_x(stream.cx, tile) + (tile_attr(key, tile, CITY_ATTR_GEM_X) % 100) / 100.0f - 0.5f;
+    g.y = 0.5f;
+    g.z = tile_world_z(stream.cz, tile) + (tile_attr(key, tile, CITY_ATTR_GEM_Z) % 100) / 100.0f - 0.5f;
+    g.type = tile_attr(key, tile, CITY_ATTR_GEM_TYPE) % 3;
+    g.collected = false;
+}
+
+// Generate up to `tiles` more tiles of a streaming chunk
+static void stream_generate(ChunkStream& stream, int tiles) {
+    int32_t key = city_chunk_key(stream.cx, stream.cz);
+
+    stream.state = CHUNK_GENERATING;
+    for (; tiles > 0 && stream.next_tile < CITY_CHUNK_WIDTH * CITY_CHUNK_WIDTH; tiles--) {
+        int tile = stream.next_tile++;
+        int ring = tile_ring(tile % CITY_CHUNK_WIDTH, tile / CITY_CHUNK_WIDTH);
+
+        if (ring == 0) {
+            generate_tile_gem(stream, tile);
+        } else if (ring == 2 && stream.building_count < MAX_BUILDINGS_PER_CHUNK) {
+            if (tile_attr(key, tile, CITY_ATTR_BUILDING_PRESENT) % 5 >= 3) continue;
+
+            Building& b = stream.buildings[stream.building_count++];
+            b.x = tile_local_fixed(tile % CITY_CHUNK_WIDTH);
+            b.z = tile_local_fixed(tile / CITY_CHUNK_WIDTH);
+            b.half_width = building_half_extent(tile_attr(key, tile, CITY_ATTR_BUILDING_WIDTH));
+            b.half_depth = building_half_extent(tile_attr(key, tile, CITY_ATTR_BUILDING_DEPTH));
+            b.height = building_height(tile_attr(key, tile, CITY_ATTR_BUILDING_HEIGHT));
+            b.color = tile_attr(key, tile, CITY_ATTR_BUILDING_COLOR) % 6;
+        }
     }
-    return -1;
+
+    if (stream.next_tile >= CITY_CHUNK_WIDTH * CITY_CHUNK_WIDTH) stream.state = CHUNK_READY;
 }
 
-void city_generate_chunk(int chunk_id) {
-    uint32_t chunk_seed = city_seed + chunk_id * 7919;
+// Generate a whole chunk at once from the batch parameters
+static void stream_generate_batch(ChunkStream& stream) {
+    static ChunkBuildingParams params;
+    city_generate_building_params(stream.cx, stream.cz, params);
+
+    stream.building_count = 0;
+    for (int i = 0; i < CITY_BUILDING_SITES && stream.building_count < MAX_BUILDINGS_PER_CHUNK; i++) {
+        if (!params.present[i]) continue;
+        Building& b = stream.buildings[stream.building_count++];
+        b.x = params.x[i];
+        b.z = params.z[i];
+        b.half_width = params.half_width[i];
+        b.half_depth = params.half_depth[i];
+        b.height = params.height[i];
+        b.color = params.color[i];
+    }
+
+    stream.gem_count = 0;
+    for (int tile = 0; tile < CITY_CHUNK_WIDTH * CITY_CHUNK_WIDTH; tile++) {
+        if (tile_ring(tile % CITY_CHUNK_WIDTH, tile / CITY_CHUNK_WIDTH) == 0) generate_tile_gem(stream, tile);
+    }
 
-    float chunk_start_x = chunk_id * CITY_CHUNK_WIDTH * TILE_SIZE_3D;
+    stream.next_tile = CITY_CHUNK_WIDTH * CITY_CHUNK_WIDTH;
+    stream.state = CHUNK_READY;
+}
 
-    for (int tx = 0; tx < CITY_CHUNK_WIDTH; tx++) {
-        if (city_random(chunk_seed) % 4 == 0) continue;
+static inline GemState& gem_state_for(int cx, int cz) {
+    int sx = cx % CITY_GEM_STATE_SIDE, sz = cz % CITY_GEM_STATE_SIDE;
+    if (sx < 0) sx += CITY_GEM_STATE_SIDE;
+    if (sz < 0) sz += CITY_GEM_STATE_SIDE;
+    return gem_state[sz * CITY_GEM_STATE_SIDE + sx];
+}
 
-        float world_x = chunk_start_x + tx * TILE_SIZE_3D;
+static inline bool chunk_live(int cx, int cz) {
+    const ChunkSlab& slab = chunk_slabs[city_window_slot(cx, cz)];
+    return slab.live && slab.cx == cx && slab.cz == cz;
+}
 
-        // Buildings on left side (negative Z)
-        if (city_random(chunk_seed) % 3 != 0) {
-            int slot = find_free_building_slot();
-            if (slot >= 0) {
-                Building& b = buildings[slot];
-                b.x = world_x;
-                b.z = -4.0f - (city_random(chunk_seed) % 3);
-                b.width = 1.5f + (city_random(chunk_seed) % 100) / 100.0f;
-                b.depth = 1.5f + (city_random(chunk_seed) % 100) / 100.0f;
-                b.height = 2.0f + (city_random(chunk_seed) % 8);
+// Make a fully generated chunk live by copying it to its window slot
+static void stream_commit(ChunkStream& stream) {
+    int slot = city_window_slot(stream.cx, stream.cz);
+    ChunkSlab& slab = chunk_slabs[slot];
+    if (slab.live) return;
+
+    slab.cx = stream.cx;
+    slab.cz = stream.cz;
+    slab.live = true;
+    slab.building_count = stream.building_count;
+    slab.gem_count = stream.gem_count;
+    active_building_count += slab.building_count;
+    active_gem_count += slab.gem_count;
+
+    int building_first = slot * MAX_BUILDINGS_PER_CHUNK;
+    float origin_x = slab.cx * CITY_CHUNK_SIZE, origin_z = slab.cz * CITY_CHUNK_SIZE;
+    for (int i = 0; i < slab.building_count; i++) {
+        const Building& b = stream.buildings[i];
+        int id = building_first + i;
+        buildings.x[id] = b.x;
+        buildings.z[id] = b.z;
+        buildings.half_width[id] = b.half_width;
+        buildings.half_depth[id] = b.half_depth;
+        buildings.height[id] = b.height;
+        buildings.color[id] = b.color;
+        spatial_insert(building_grid, id, origin_x + (float)b.x / CITY_FIXED_ONE,
+                       origin_z + (float)b.z / CITY_FIXED_ONE);
+    }
+    const GemState& gems_collected = gem_state_for(slab.cx, slab.cz);
+    uint16_t collected = (gems_collected.cx == slab.cx && gems_collected.cz == slab.cz)
+                         ? gems_collected.collected : 0;
+    int gem_first = slot * MAX_GEMS_PER_CHUNK;
+    for (int i = 0; i < slab.gem_count; i++) {
+        Gem3D& g = gems_3d[gem_first + i];
+        g = stream.gems[i];
+        if (collected & (1u << i)) g.collected = true;
+        spatial_insert(gem_grid, gem_first + i, g.x, g.z);
+    }
 
-                int color_idx = city_random(chunk_seed) % 6;
-                b.r_wall = building_colors[color_idx][0];
-                b.g_wall = building_colors[color_idx][1];
-                b.b_wall = building_colors[color_idx][2];
-                b.r_roof = roof_colors[color_idx][0];
-                b.g_roof = roof_colors[color_idx][1];
-                b.b_roof = roof_colors[color_idx][2];
+    stream.state = CHUNK_FREE;
+}
 
-                b.active = true;
-                b.chunk_id = chunk_id;
-                active_building_count++;
-            }
+static ChunkStream* find_cached(int cx, int cz) {
+    for (int i = 0; i < CITY_CHUNK_CACHE_SLOTS; i++) {
+        const ChunkStream& entry = chunk_cache[i];
+        if (entry.state == CHUNK_READY && entry.cx == cx && entry.cz == cz) {
+            return &chunk_cache[i];
         }
+    }
+    return nullptr;
+}
 
-        // Buildings on right side (positive Z)
-        if (city_random(chunk_seed) % 3 != 0) {
-            int slot = find_free_building_slot();
-            if (slot >= 0) {
-                Building& b = buildings[slot];
-                b.x = world_x;
-                b.z = 4.0f + (city_random(chunk_seed) % 3);
-                b.width = 1.5f + (city_random(chunk_seed) % 100) / 100.0f;
-                b.depth = 1.5f + (city_random(chunk_seed) % 100) / 100.0f;
-                b.height = 2.0f + (city_random(chunk_seed) % 8);
-
-                int color_idx = city_random(chunk_seed) % 6;
-                b.r_wall = building_colors[color_idx][0];
-                b.g_wall = building_colors[color_idx][1];
-                b.b_wall = building_colors[color_idx][2];
-                b.r_roof = roof_colors[color_idx][0];
-                b.g_roof = roof_colors[color_idx][1];
-                b.b_roof = roof_colors[color_idx][2];
-
-                b.active = true;
-                b.chunk_id = chunk_id;
-                active_building_count++;
-            }
+// Copy a live slab into the cache, evicting the least recently used entry
+static void cache_slab(int slot) {
+    const ChunkSlab& slab = chunk_slabs[slot];
+
+    int victim = 0;
+    for (int i = 0; i < CITY_CHUNK_CACHE_SLOTS; i++) {
+        if (chunk_cache[i].state == CHUNK_FREE) { victim = i; break; }
+        if (chunk_cache_last_used[i] < chunk_cache_last_used[victim]) victim = i;
+    }
+
+    ChunkStream& entry = chunk_cache[victim];
+    entry.cx = slab.cx;
+    entry.cz = slab.cz;
+    entry.state = CHUNK_READY;
+    entry.next_tile = CITY_CHUNK_WIDTH * CITY_CHUNK_WIDTH;
+    entry.building_count = slab.building_count;
+    entry.gem_count = slab.gem_count;
+    for (int i = 0; i < slab.building_count; i++) {
+        int id = slot * MAX_BUILDINGS_PER_CHUNK + i;
+        Building& b = entry.buildings[i];
+        b.x = buildings.x[id];
+        b.z = buildings.z[id];
+        b.half_width = buildings.half_width[id];
+        b.half_depth = buildings.half_depth[id];
+        b.height = buildings.height[id];
+        b.color = buildings.color[id];
+    }
+    for (int i = 0; i < slab.gem_count; i++) {
+        entry.gems[i] = gems_3d[slot * MAX_GEMS_PER_CHUNK + i];
+    }
+    chunk_cache_last_used[victim] = ++chunk_cache_clock;
+}
+
+// Record a collected gem in its chunk's persistent bitset
+static void remember_gem_collected(int gem_slot) {
+    const ChunkSlab& slab = chunk_slabs[gem_slot / MAX_GEMS_PER_CHUNK];
+    GemState& state = gem_state_for(slab.cx, slab.cz);
+    if (state.cx != slab.cx || state.cz != slab.cz) {
+        state.cx = slab.cx;
+        state.cz = slab.cz;
+        state.collected = 0;
+    }
+    state.collected |= 1u << (gem_slot % MAX_GEMS_PER_CHUNK);
+}
+
+static ChunkStream* find_stream(int cx, int cz) {
+    for (int i = 0; i < CITY_STREAM_SLOTS; i++) {
+        const ChunkStream& stream = chunk_streams[i];
+        if (stream.state != CHUNK_FREE && stream.cx == cx && stream.cz == cz) {
+            return &chunk_streams[i];
         }
+    }
+    return nullptr;
+}
 
-        // Spawn gems on the street
-        if (city_random(chunk_seed) % 5 == 0) {
-            int slot = find_free_gem_slot();
-            if (slot >= 0) {
-                Gem3D& g = gems_3d[slot];
-                g.x = world_x + (city_random(chunk_seed) % 100) / 50.0f - 1.0f;
-                g.y = 0.5f;
-                g.z = (city_random(chunk_seed) % 100) / 50.0f - 1.0f;
-                g.type = city_random(chunk_seed) % 3;
-                g.collected = false;
-                g.active = true;
-                g.chunk_id = chunk_id;
-            }
+// Queue a chunk for background generation (no-op if queued, cached or no slot free)
+static void stream_request(int cx, int cz) {
+    if (find_stream(cx, cz) || find_cached(cx, cz)) return;
+    for (int i = 0; i < CITY_STREAM_SLOTS; i++) {
+        if (chunk_streams[i].state == CHUNK_FREE) {
+            stream_begin(chunk_streams[i], cx, cz);
+            return;
         }
     }
 }
 
-void city_remove_chunk(int chunk_id) {
-    for (int i = 0; i < MAX_BUILDINGS; i++) {
-        if (buildings[i].active && buildings[i].chunk_id == chunk_id) {
-            buildings[i].active = false;
-            active_building_count--;
+void city_generate_chunk(int cx, int cz) {
+    // Use a cached copy or finish a background stream if there is one,
+    // otherwise generate from scratch
+    ChunkStream* stream = find_cached(cx, cz);
+    if (!stream) stream = find_stream(cx, cz);
+    if (!stream) {
+        stream = &scratch_stream;
+        stream_begin(*stream, cx, cz);
+        stream_generate_batch(*stream);
+    } else {
+        stream_generate(*stream, CITY_CHUNK_WIDTH * CITY_CHUNK_WIDTH);
+    }
+    stream_commit(*stream);
+}
+
+ChunkState city_chunk_state(int cx, int cz) {
+    if (chunk_live(cx, cz)) return CHUNK_LIVE;
+    ChunkStream* stream = find_cached(cx, cz);
+    if (!stream) stream = find_stream(cx, cz);
+    return stream ? stream->state : CHUNK_FREE;
+}
+
+void city_remove_chunk(int cx, int cz) {
+    if (!chunk_live(cx, cz)) return;
+
+    int slot = city_window_slot(cx, cz);
+    ChunkSlab& slab = chunk_slabs[slot];
+    cache_slab(slot);
+    for (int i = 0; i < slab.building_count; i++) {
+        spatial_remove(building_grid, slot * MAX_BUILDINGS_PER_CHUNK + i);
+    }
+    for (int i = 0; i < slab.gem_count; i++) {
+        spatial_remove(gem_grid, slot * MAX_GEMS_PER_CHUNK + i);
+    }
+
+    active_building_count -= slab.building_count;
+    active_gem_count -= slab.gem_count;
+    slab.live = false;
+}
+
+// Make a missing window chunk live if it's ready, otherwise make sure it's
+// being generated
+static void stream_extend(int cx, int cz) {
+    ChunkStream* stream = find_cached(cx, cz);
+    if (!stream) stream = find_stream(cx, cz);
+    if (stream && stream->state == CHUNK_READY) {
+        stream_commit(*stream);
+        return;
+    }
+    stream_request(cx, cz);
+}
+
+static inline int chunk_distance(int cx, int cz, int to_cx, int to_cz) {
+    return std::max(abs(cx - to_cx), abs(cz - to_cz));
+}
+
+void city_update_chunks(float camera_x, float camera_z, uint32_t budget_us) {
+    int camera_cx = city_chunk_of(camera_x);
+    int camera_cz = city_chunk_of(camera_z);
+    int radius = city_window_radius;
+
+    // Prefetch along whichever axis the camera moved most on
+    float dx = camera_x - stream_last_camera_x;
+    float dz = camera_z - stream_last_camera_z;
+    if (fabsf(dx) >= fabsf(dz) && dx != 0.0f) {
+        stream_direction_x = dx > 0 ? 1 : -1;
+        stream_direction_z = 0;
+    } else if (dz != 0.0f) {
+        stream_direction_x = 0;
+        stream_direction_z = dz > 0 ? 1 : -1;
+    }
+    stream_last_camera_x = camera_x;
+    stream_last_camera_z = camera_z;
+
+    // Unload chunks that left the window, freeing their slots for the
+    // chunks entering on the opposite edge
+    for (int slot = 0; slot < CITY_WINDOW_SLOTS; slot++) {
+        const ChunkSlab& slab = chunk_slabs[slot];
+        if (slab.live && chunk_distance(slab.cx, slab.cz, camera_cx, camera_cz) > radius) {
+            city_remove_chunk(slab.cx, slab.cz);
+        }
+    }
+    city_chunk_cx = camera_cx;
+    city_chunk_cz = camera_cz;
+
+    // The camera's own chunk is needed for collision this frame
+    if (!chunk_live(camera_cx, camera_cz)) city_generate_chunk(camera_cx, camera_cz);
+
+    // Fill the rest of the window nearest ring first with whatever is ready
+    for (int d = 1; d <= radius; d++) {
+        for (int cz = camera_cz - d; cz <= camera_cz + d; cz++) {
+            int step = (cz == camera_cz - d || cz == camera_cz + d) ? 1 : 2 * d;
+            for (int cx = camera_cx - d; cx <= camera_cx + d; cx += step) {
+                if (!chunk_live(cx, cz)) stream_extend(cx, cz);
+            }
         }
     }
 
-    for (int i = 0; i < MAX_GEMS_3D; i++) {
-        if (gems_3d[i].active && gems_3d[i].chunk_id == chunk_id) {
-            gems_3d[i].active = false;
+    // Drop streams that are no longer near the window, then prefetch ahead
+    for (int i = 0; i < CITY_STREAM_SLOTS; i++) {
+        ChunkStream& stream = chunk_streams[i];
+        if (stream.state == CHUNK_FREE) continue;
+        if (chunk_distance(stream.cx, stream.cz, camera_cx, camera_cz) > radius + 1) {
+            stream.state = CHUNK_FREE;
         }
     }
+    stream_request(camera_cx + stream_direction_x * (radius + 1),
+                   camera_cz + stream_direction_z * (radius + 1));
+
+    // Spend the budget on the unfinished stream nearest the camera
+    uint32_t start = time_us();
+    do {
+        ChunkStream* best = nullptr;
+        int best_dist = 0;
+        for (int i = 0; i < CITY_STREAM_SLOTS; i++) {
+            ChunkStream& stream = chunk_streams[i];
+            if (stream.state != CHUNK_REQUESTED && stream.state != CHUNK_GENERATING) continue;
+            int dist = chunk_distance(stream.cx, stream.cz, camera_cx, camera_cz);
+            if (!best || dist < best_dist) { best = &stream; best_dist = dist; }
+        }
+        if (!best) break;
+        stream_generate(*best, CITY_CHUNK_WIDTH);
+    } while (time_us() - start < budget_us);
+}
+
+bool city_is_street(float x, float z) {
+    int tx = (int)floorf((x - city_chunk_of(x) * CITY_CHUNK_SIZE) / TILE_SIZE_3D);
+    int tz = (int)floorf((z - city_chunk_of(z) * CITY_CHUNK_SIZE) / TILE_SIZE_3D);
+    return tile_ring(std::min(std::max(tx, 0), CITY_CHUNK_WIDTH - 1),
+                     std::min(std::max(tz, 0), CITY_CHUNK_WIDTH - 1)) == 0;
+}
+
+// Cull a chunk against the camera view and draw distance
+static inline bool chunk_in_view(const ChunkSlab& slab) {
+    float min_x = slab.cx * CITY_CHUNK_SIZE, min_z = slab.cz * CITY_CHUNK_SIZE;
+    return render3d_visible_xz(min_x, min_z, min_x + CITY_CHUNK_SIZE, min_z + CITY_CHUNK_SIZE,
+                               city_draw_distance);
 }
 
-void city_update_chunks(float camera_x) {
-    int camera_chunk = (int)(camera_x / (CITY_CHUNK_WIDTH * TILE_SIZE_3D));
-    int desired_left = camera_chunk - 1;
-    int desired_right = camera_chunk + 2;
+// View wedge and draw distance relative to one chunk's origin, in building
+// fixed point, so that chunk's buildings can be culled with integer math
+struct ChunkView {
+    int32_t camera_x, camera_z;
+    int32_t apex_x, apex_z;
+    int32_t normal_x[2], normal_z[2];  // Side plane normals, scaled by VIEW_NORMAL_ONE
+    int32_t max_dist_sq;
+};
+
+static const float VIEW_NORMAL_ONE = 1024.0f;
 
-    while (city_chunk_left < desired_left) {
-        city_remove_chunk(city_chunk_left);
-        city_chunk_left++;
+// Frame constants for chunk_view_for (float, set by city_begin_view)
+static float view_camera_x, view_camera_z;
+static float view_apex_x, view_apex_z;
+static float view_normals[2][2];
+
+static void city_begin_view() {
+    render3d_camera_xz(view_camera_x, view_camera_z);
+    render3d_view_wedge(view_apex_x, view_apex_z, view_normals);
+}
+
+static void chunk_view_for(const ChunkSlab& slab, ChunkView& view) {
+    float origin_x = slab.cx * CITY_CHUNK_SIZE, origin_z = slab.cz * CITY_CHUNK_SIZE;
+    view.camera_x = (int32_t)((view_camera_x - origin_x) * CITY_FIXED_ONE);
+    view.camera_z = (int32_t)((view_camera_z - origin_z) * CITY_FIXED_ONE);
+    view.apex_x = (int32_t)((view_apex_x - origin_x) * CITY_FIXED_ONE);
+    view.apex_z = (int32_t)((view_apex_z - origin_z) * CITY_FIXED_ONE);
+    for (int p = 0; p < 2; p++) {
+        view.normal_x[p] = (int32_t)(view_normals[p][0] * VIEW_NORMAL_ONE);
+        view.normal_z[p] = (int32_t)(view_normals[p][1] * VIEW_NORMAL_ONE);
     }
+    // Window chunks are never further than this, so larger distances can't overflow
+    float max_dist = std::min(city_draw_distance, 120.0f) * CITY_FIXED_ONE;
+    view.max_dist_sq = (int32_t)(max_dist * max_dist);
+}
 
-    while (city_chunk_right > desired_right) {
-        city_remove_chunk(city_chunk_right);
-        city_chunk_right--;
+// Integer version of render3d_visible_xz for a building of the view's chunk
+static inline bool building_in_view(const ChunkView& view, int id) {
+    int32_t x = buildings.x[id], z = buildings.z[id];
+    int32_t hw = buildings.half_width[id], hd = buildings.half_depth[id];
+
+    // Nearest point of the footprint to the camera
+    int32_t nx = std::min(std::max(view.camera_x, x - hw), x + hw) - view.camera_x;
+    int32_t nz = std::min(std::max(view.camera_z, z - hd), z + hd) - view.camera_z;
+    if (nx * nx + nz * nz > view.max_dist_sq) return false;
+
+    // Outside if the footprint's furthest corner along a side plane normal is behind it
+    for (int p = 0; p < 2; p++) {
+        int32_t px = view.normal_x[p], pz = view.normal_z[p];
+        int32_t reach = abs(px) * hw + abs(pz) * hd;
+        if (px * (x - view.apex_x) + pz * (z - view.apex_z) + reach < 0) return false;
     }
+    return true;
+}
 
-    while (city_chunk_left > desired_left) {
-        city_chunk_left--;
-        city_generate_chunk(city_chunk_left);
+// Fixed-point building, in render3d's world units
+static inline void building_box_fx(const ChunkSlab& slab, int id, int32_t box[6]) {
+    const int shift = 10 - CITY_FIXED_SHIFT;
+    static_assert(RENDER3D_FIXED_ONE == 1 << 10, "building_box_fx assumes 1024 render units");
+    box[0] = (slab.cx * CITY_CHUNK_SIZE_FIXED + buildings.x[id]) << shift;
+    box[1] = 0;
+    box[2] = (slab.cz * CITY_CHUNK_SIZE_FIXED + buildings.z[id]) << shift;
+    box[3] = (2 * buildings.half_width[id]) << shift;
+    box[4] = buildings.height[id] << shift;
+    box[5] = (2 * buildings.half_depth[id]) << shift;
+}
+
+void city_build_occluders() {
+    render3d_occlusion_begin();
+    city_buildings_occluded = 0;
+    city_gems_occluded = 0;
+    city_begin_view();
+
+    // Keep the nearest few large buildings in view (insertion sort by distance)
+    const int32_t min_height = (int32_t)(CITY_OCCLUDER_MIN_HEIGHT * CITY_FIXED_ONE);
+    const int32_t max_dist = (int32_t)(CITY_OCCLUDER_DISTANCE * CITY_FIXED_ONE);
+    int32_t occluder_dist[CITY_MAX_OCCLUDERS];
+    occluder_count = 0;
+    for (int slot = 0; slot < CITY_WINDOW_SLOTS; slot++) {
+        const ChunkSlab& slab = chunk_slabs[slot];
+        if (!slab.live || !chunk_in_view(slab)) continue;
+
+        ChunkView view;
+        chunk_view_for(slab, view);
+        int first = slot * MAX_BUILDINGS_PER_CHUNK;
+        for (int id = first; id < first + slab.building_count; id++) {
+            if (buildings.height[id] < min_height) continue;
+            int32_t dx = buildings.x[id] - view.camera_x, dz = buildings.z[id] - view.camera_z;
+            if (abs(dx) > max_dist || abs(dz) > max_dist) continue;
+            int32_t dist = dx * dx + dz * dz;
+            if (dist > max_dist * max_dist) continue;
+            if (occluder_count == CITY_MAX_OCCLUDERS && dist >= occluder_dist[occluder_count - 1]) continue;
+            if (!building_in_view(view, id)) continue;
+
+            int k = std::min(occluder_count, CITY_MAX_OCCLUDERS - 1);
+            for (; k > 0 && occluder_dist[k - 1] > dist; k--) {
+                occluder_dist[k] = occluder_dist[k - 1];
+                occluder_slots[k] = occluder_slots[k - 1];
+            }
+            occluder_dist[k] = dist;
+            occluder_slots[k] = id;
+            if (occluder_count < CITY_MAX_OCCLUDERS) occluder_count++;
+        }
     }
 
-    while (city_chunk_right < desired_right) {
-        city_chunk_right++;
-        city_generate_chunk(city_chunk_right);
+    for (int k = 0; k < occluder_count; k++) {
+        int id = occluder_slots[k];
+        int32_t box[6];
+        building_box_fx(chunk_slabs[id / MAX_BUILDINGS_PER_CHUNK], id, box);
+        render3d_occluder_box_fx(box[0], box[1], box[2], box[3], box[4], box[5]);
     }
 }
 
-void city_render() {
-    for (int i = 0; i < MAX_BUILDINGS; i++) {
-        if (!buildings[i].active) continue;
-
-        const Building& b = buildings[i];
+static inline bool is_occluder(int id) {
+    for (int k = 0; k < occluder_count; k++) {
+        if (occluder_slots[k] == id) return true;
+    }
+    return false;
+}
 
-        render3d_cube(b.x, 0, b.z, b.width, b.height, b.depth,
-                      b.r_roof, b.g_roof, b.b_roof,
-                      b.r_wall, b.g_wall, b.b_wall);
+void city_render_floor(float x, float z) {
+    // Floor tiles are centred on multiples of 4 so streets (on chunk borders) get whole tiles
+    int center_x = (int)floorf(x / 4.0f + 0.5f);
+    int center_z = (int)floorf(z / 4.0f + 0.5f);
+    for (int gx = -5; gx <= 5; gx++) {
+        for (int gz = -5; gz <= 5; gz++) {
+            int grid_x = center_x + gx;
+            int grid_z = center_z + gz;
+            float tile_x = grid_x * 4.0f;
+            float tile_z = grid_z * 4.0f;
+            if (!render3d_visible_xz(tile_x - 2.0f, tile_z - 2.0f, tile_x + 2.0f, tile_z + 2.0f,
+                                     city_draw_distance)) continue;
+            bool street = city_is_street(tile_x, tile_z);
+            bool dark = ((grid_x + grid_z) & 1) == 0;
+            uint8_t cr = street ? 50 : dark ? 75 : 85;
+            uint8_t cg = street ? 50 : dark ? 75 : 85;
+            uint8_t cb = street ? 60 : dark ? 85 : 95;
+            render3d_cube_if_visible(tile_x, -0.5f, tile_z, 4.0f, 0.5f, 4.0f, cr, cg, cb, cr, cg, cb);
+        }
     }
 }
 
-// Gem billboard drawing function
-static void draw_gem_3d(int cx, int cy, float scale, uint8_t depth, uint8_t type, uint32_t time, color_t* fb) {
-    static const uint8_t gem_colors[3][3] = {
-        {255, 50, 50},   // Red
-        {50, 255, 50},   // Green
-        {50, 150, 255}   // Blue
-    };
+void city_render() {
+    city_chunks_drawn = 0;
+    city_buildings_drawn = 0;
+    city_props_drawn = 0;
+    city_begin_view();
+
+    for (int slot = 0; slot < CITY_WINDOW_SLOTS; slot++) {
+        const ChunkSlab& slab = chunk_slabs[slot];
+        if (!slab.live || !chunk_in_view(slab)) continue;
+        city_chunks_drawn++;
+
+        ChunkView view;
+        chunk_view_for(slab, view);
+        int first = slot * MAX_BUILDINGS_PER_CHUNK;
+        for (int id = first; id < first + slab.building_count; id++) {
+            if (!building_in_view(view, id)) continue;
+
+            int32_t box[6];
+            building_box_fx(slab, id, box);
+            const uint8_t* wall = building_colors[buildings.color[id]];
+            const uint8_t* roof = roof_colors[buildings.color[id]];
+            int texture = buildings.color[id] == BRICK_BUILDING_COLOR ? TEXTURE_BRICK : RENDER3D_NO_TEXTURE;
+
+            // Occluders must be drawn, since the map assumes they are
+            if (is_occluder(id)) {
+                render3d_cube_fx(box[0], box[1], box[2], box[3], box[4], box[5],
+                                 roof[0], roof[1], roof[2], wall[0], wall[1], wall[2], texture);
+            } else if (!render3d_cube_if_visible_fx(box[0], box[1], box[2], box[3], box[4], box[5],
+                                                    roof[0], roof[1], roof[2], wall[0], wall[1], wall[2],
+                                                    texture)) {
+                city_buildings_occluded++;
+                continue;
+            }
+            city_buildings_drawn++;
+        }
 
-    uint8_t r = gem_colors[type][0];
-    uint8_t g = gem_colors[type][1];
-    uint8_t b = gem_colors[type][2];
+        // Props are drawn after the buildings so they are occlusion tested
+        if (!props_loaded) continue;
+        float prop_distance = std::min(city_draw_distance, CITY_PROP_DRAW_DISTANCE);
+        int32_t key = city_chunk_key(slab.cx, slab.cz);
+        for (int i = 0; i < 4; i++) {
+            int tile = prop_tree_tiles[i];
+            if (tile_attr(key, tile, CITY_ATTR_PROP_PRESENT) % PROP_TREE_CHANCE != 0) continue;
+            if (mesh_render(tree_mesh, (int32_t)(tile_world_x(slab.cx, tile) * RENDER3D_FIXED_ONE), 0,
+                            (int32_t)(tile_world_z(slab.cz, tile) * RENDER3D_FIXED_ONE), 0.0f, prop_distance)) {
+                city_props_drawn++;
+            }
+        }
+        if (slab.cx == 0 && slab.cz == 0 &&
+            mesh_render(sleigh_mesh, (int32_t)(SLEIGH_X * RENDER3D_FIXED_ONE), 0,
+                        (int32_t)(SLEIGH_Z * RENDER3D_FIXED_ONE), 0.0f, prop_distance)) {
+            city_props_drawn++;
+        }
+    }
+}
 
-    int bob = (int)(sinf(time / 200.0f) * 2 * scale);
-    cy += bob;
+// Bob offset per unit of scale, computed once per frame
+static float gem_bob = 0.0f;
+
+// One clipped, depth-tested row of a gem, pixels [x0, x1)
+static inline void draw_gem_span(int py, int x0, int x1, color_t color, uint8_t depth, color_t* fb) {
+    if (x0 < 0) x0 = 0;
+    if (x1 > SCREEN_WIDTH) x1 = SCREEN_WIDTH;
+    if (x0 >= x1) return;
+
+    uint8_t* depth_row = &depth_buffer_display[py * DEPTH_WIDTH];
+    if (fb) {
+        color_t* row = &fb[py * SCREEN_WIDTH];
+        for (int px = x0; px < x1; px++) {
+            if (depth < depth_row[px]) {
+                depth_row[px] = depth;
+                row[px] = color;
+            }
+        }
+    } else {
+        pen(color);
+        for (int px = x0; px < x1; px++) {
+            if (depth < depth_row[px]) {
+                depth_row[px] = depth;
+                pixel(px, py);
+            }
+        }
+    }
+}
 
+// Depth-tested span blit of a cached gem sprite; gems too close for the
+// cache get the same diamond with its rows worked out as they are drawn
+static void draw_gem_3d(int cx, int cy, float scale, uint8_t depth, uint8_t type, color_t* fb) {
     int size = (int)(3 * scale);
     if (size < 1) size = 1;
+    cy += (int)(gem_bob * scale);
+
+    const color_t* colors = gem_sprite_colors[type];
+    if (size <= GEM_SPRITE_MAX_SIZE) {
+        for (int s = gem_size_first[size - 1]; s < gem_size_first[size]; s++) {
+            const GemSpan& span = gem_spans[s];
+            int py = cy + span.dy;
+            if (py < 0) continue;
+            if (py >= SCREEN_HEIGHT) break;
+            int x0 = cx + span.dx;
+            draw_gem_span(py, x0, x0 + (span.length & ~GEM_SPAN_HIGHLIGHT),
+                          colors[(span.length & GEM_SPAN_HIGHLIGHT) ? 1 : 0], depth, fb);
+        }
+        return;
+    }
 
-    for (int dy = -size; dy <= size; dy++) {
+    for (int dy = std::max(-size, -cy); dy <= size && cy + dy < SCREEN_HEIGHT; dy++) {
+        int py = cy + dy;
         int width = size - abs(dy);
-        for (int dx = -width; dx <= width; dx++) {
-            int px = cx + dx;
-            int py = cy + dy;
-            if (px >= 0 && px < SCREEN_WIDTH && py >= 0 && py < SCREEN_HEIGHT) {
-                if (depth_test(px, py, depth)) {
-                    uint8_t rr = r, gg = g, bb = b;
-                    if (abs(dx) <= 1 && dy < 0) {
-                        rr = std::min(255, r + 50);
-                        gg = std::min(255, g + 50);
-                        bb = std::min(255, b + 50);
-                    }
-                    if (fb) {
-                        fb[py * SCREEN_WIDTH + px] = rgb_to_color(rr, gg, bb);
-                    } else {
-                        pen(rr >> 4, gg >> 4, bb >> 4);
-                        pixel(px, py);
-                    }
-                }
-            }
+        if (dy < 0 && width >= 2) {
+            draw_gem_span(py, cx - width, cx - 1, colors[0], depth, fb);
+            draw_gem_span(py, cx - 1, cx + 2, colors[1], depth, fb);
+            draw_gem_span(py, cx + 2, cx + width + 1, colors[0], depth, fb);
+        } else {
+            draw_gem_span(py, cx - width, cx + width + 1, colors[dy < 0 ? 1 : 0], depth, fb);
         }
     }
 }
 
-static uint32_t gem_render_time = 0;
 static uint8_t current_gem_type = 0;
 static color_t* gem_framebuffer = nullptr;
 
 static void gem_draw_callback(int x, int y, float scale, uint8_t depth, color_t* fb) {
-    draw_gem_3d(x, y, scale, depth, current_gem_type, gem_render_time, fb);
+    draw_gem_3d(x, y, scale, depth, current_gem_type, fb);
 }
 
 void city_render_gems(uint32_t time, color_t* fb) {
-    gem_render_time = time;
+    gem_bob = sinf(time / 200.0f) * 2;
     gem_framebuffer = fb;
 
-    for (int i = 0; i < MAX_GEMS_3D; i++) {
-        if (!gems_3d[i].active || gems_3d[i].collected) continue;
+    for (int slot = 0; slot < CITY_WINDOW_SLOTS; slot++) {
+        const ChunkSlab& slab = chunk_slabs[slot];
+        if (!slab.live || !chunk_in_view(slab)) continue;
+
+        const Gem3D* chunk_gems = &gems_3d[slot * MAX_GEMS_PER_CHUNK];
+        for (int i = 0; i < slab.gem_count; i++) {
+            const Gem3D& g = chunk_gems[i];
+            if (g.collected) continue;
+            if (render3d_box_occluded(g.x, g.y - GEM_OCCLUSION_HALF_EXTENT, g.z, 2 * GEM_OCCLUSION_HALF_EXTENT,
+                                      2 * GEM_OCCLUSION_HALF_EXTENT, 2 * GEM_OCCLUSION_HALF_EXTENT)) {
+                city_gems_occluded++;
+                continue;
+            }
 
-        const Gem3D& g = gems_3d[i];
-        current_gem_type = g.type;
+            current_gem_type = g.type;
 
-        render3d_billboard(g.x, g.y, g.z, gem_draw_callback, 1.0f, fb);
+            render3d_billboard(g.x, g.y, g.z, gem_draw_callback, 1.0f, fb);
+        }
     }
 }
 
 bool city_check_collision(float x, float z, float radius) {
-    for (int i = 0; i < MAX_BUILDINGS; i++) {
-        if (!buildings[i].active) continue;
+    int16_t candidates[MAX_QUERY_CANDIDATES];
+    float reach = radius + BUILDING_MAX_HALF_EXTENT;
+    int count = spatial_query_aabb(building_grid, x - reach, z - reach, x + reach, z + reach,
+                                   candidates, MAX_QUERY_CANDIDATES);
+    city_collision_visits = count;
 
-        const Building& b = buildings[i];
+    // Query point in world fixed point; each candidate is offset by its chunk origin
+    int32_t fx = (int32_t)(x * CITY_FIXED_ONE);
+    int32_t fz = (int32_t)(z * CITY_FIXED_ONE);
+    int32_t fr = (int32_t)(radius * CITY_FIXED_ONE);
 
-        float half_w = b.width / 2 + radius;
-        float half_d = b.depth / 2 + radius;
+    for (int c = 0; c < count; c++) {
+        int id = candidates[c];
+        const ChunkSlab& slab = chunk_slabs[id / MAX_BUILDINGS_PER_CHUNK];
 
-        float dx = x - b.x;
-        float dz = z - b.z;
+        int32_t dx = fx - slab.cx * CITY_CHUNK_SIZE_FIXED - buildings.x[id];
+        int32_t dz = fz - slab.cz * CITY_CHUNK_SIZE_FIXED - buildings.z[id];
 
-        if (fabsf(dx) < half_w && fabsf(dz) < half_d) {
+        if (abs(dx) < buildings.half_width[id] + fr && abs(dz) < buildings.half_depth[id] + fr) {
             return true;
         }
     }
@@ -289,10 +979,14 @@ bool city_check_collision(float x, float z, float radius) {
 int city_collect_gem(float player_x, float player_z, float collect_radius) {
     int points = 0;
 
-    for (int i = 0; i < MAX_GEMS_3D; i++) {
-        if (!gems_3d[i].active || gems_3d[i].collected) continue;
+    int16_t candidates[MAX_QUERY_CANDIDATES];
+    int count = spatial_query_radius(gem_grid, player_x, player_z, collect_radius,
+                                     candidates, MAX_QUERY_CANDIDATES);
+    city_gem_visits = count;
 
-        Gem3D& g = gems_3d[i];
+    for (int c = 0; c < count; c++) {
+        Gem3D& g = gems_3d[candidates[c]];
+        if (g.collected) continue;
 
         float dx = player_x - g.x;
         float dz = player_z - g.z;
@@ -300,6 +994,7 @@ int city_collect_gem(float player_x, float player_z, float collect_radius) {
 
         if (dist_sq < collect_radius * collect_radius) {
             g.collected = true;
+            remember_gem_collected(candidates[c]);
             points += (g.type + 1) * 10;
         }
     }
@@ -2,19 +2,64 @@
 #include "render3d.hpp"
 
 // City generation constants
-constexpr int CITY_CHUNK_WIDTH = 10;   // Tiles per chunk
-constexpr int MAX_BUILDINGS = 32;      // Maximum buildings in memory
+// The city is a grid of square chunks. The outer ring of tiles of every chunk
+// is street, so streets run along all chunk borders and cross at the corners;
+// the next ring is pavement and the one inside that holds the building sites.
+constexpr int CITY_CHUNK_WIDTH = 10;   // Tiles per chunk side
 constexpr float TILE_SIZE_3D = 2.0f;   // World units per tile
+constexpr float CITY_CHUNK_SIZE = CITY_CHUNK_WIDTH * TILE_SIZE_3D;  // World units per chunk side
+constexpr int CITY_BUILDING_SITES = 4 * (CITY_CHUNK_WIDTH - 5);     // Tiles in the building ring
+constexpr int MAX_BUILDINGS_PER_CHUNK = 16;  // Extra buildings in a chunk are dropped
+constexpr int MAX_GEMS_PER_CHUNK = 8;        // Extra gems in a chunk are dropped
+constexpr int CITY_MAX_WINDOW_RADIUS = 2;    // Loaded window is up to (2r+1)^2 chunks around the camera
+constexpr int CITY_WINDOW_SIDE = 2 * CITY_MAX_WINDOW_RADIUS + 1;
+constexpr int CITY_WINDOW_SLOTS = CITY_WINDOW_SIDE * CITY_WINDOW_SIDE;
+constexpr int MAX_BUILDINGS = CITY_WINDOW_SLOTS * MAX_BUILDINGS_PER_CHUNK;  // One slab per window slot
+constexpr float CITY_DRAW_DISTANCE = 50.0f;       // Default draw distance in world units
+constexpr float CITY_FOG_START = 0.6f;            // Fog starts at this fraction of the draw distance
+constexpr int CITY_MAX_OCCLUDERS = 6;             // Nearest buildings drawn into the occlusion map
+constexpr float CITY_OCCLUDER_DISTANCE = 24.0f;   // Only buildings this close are occluders
+constexpr float CITY_OCCLUDER_MIN_HEIGHT = 3.0f;  // Low buildings hide too little to be worth it
+constexpr float CITY_PROP_DRAW_DISTANCE = 24.0f;  // Mesh props further than this are only a few pixels
+constexpr int CITY_STREAM_SLOTS = CITY_WINDOW_SIDE;  // Chunks that can be generating at once (one window edge)
+constexpr uint32_t CITY_STREAM_BUDGET_US = 200;   // Chunk generation time per update
+constexpr int CITY_CHUNK_CACHE_SLOTS = CITY_WINDOW_SIDE;  // Recently unloaded chunks kept (~330 bytes each)
+constexpr int CITY_GEM_STATE_SIDE = 16;           // Collected gems are remembered for a 16x16 chunk area
+constexpr int CITY_GEM_STATE_CHUNKS = CITY_GEM_STATE_SIDE * CITY_GEM_STATE_SIDE;  // 6 bytes each
+
+// Chunk streaming states (a chunk becomes live when it's copied to its window slot)
+enum ChunkState : uint8_t {
+    CHUNK_FREE,        // Stream slot unused
+    CHUNK_REQUESTED,   // Wanted, generation not started
+    CHUNK_GENERATING,  // Some tiles generated
+    CHUNK_READY,       // Fully generated, waiting to be made live
+    CHUNK_LIVE,        // In its window slot
+};
+
+// Building positions and sizes are fixed point, relative to the minimum
+// corner of the building's chunk, so they fit in int16
+constexpr int CITY_FIXED_SHIFT = 8;                         // 1/256 world unit
+constexpr int32_t CITY_FIXED_ONE = 1 << CITY_FIXED_SHIFT;
+constexpr int32_t CITY_CHUNK_SIZE_FIXED = (int32_t)CITY_CHUNK_SIZE * CITY_FIXED_ONE;
 
-// Building structure
+// A building while a chunk is staged (streaming or cached)
 struct Building {
-    float x, z;              // World position
-    float width, depth;      // Size in world units
-    float height;            // Height in world units
-    uint8_t r_roof, g_roof, b_roof;    // Roof color
-    uint8_t r_wall, g_wall, b_wall;    // Wall color
-    bool active;             // Is this building slot in use?
-    int chunk_id;            // Which chunk owns this building
+    int16_t x, z;                    // Centre
+    int16_t half_width, half_depth;  // Half extents on x / z
+    int16_t height;
+    uint8_t color;                   // Index into the wall / roof palettes
+};
+
+// Live buildings as structure-of-arrays columns by building slot, so the
+// culling and collision loops only stream the columns they read. The chunk
+// origin comes from the slot's window chunk.
+struct BuildingStore {
+    int16_t x[MAX_BUILDINGS];
+    int16_t z[MAX_BUILDINGS];
+    int16_t half_width[MAX_BUILDINGS];
+    int16_t half_depth[MAX_BUILDINGS];
+    int16_t height[MAX_BUILDINGS];
+    uint8_t color[MAX_BUILDINGS];
 };
 
 // Gem structure for 3D
@@ -22,38 +67,91 @@ struct Gem3D {
     float x, y, z;           // World position
     uint8_t type;            // Color type (0=red, 1=green, 2=blue)
     bool collected;
-    bool active;
-    int chunk_id;
 };
 
 // Maximum gems
-constexpr int MAX_GEMS_3D = 50;
+constexpr int MAX_GEMS_3D = CITY_WINDOW_SLOTS * MAX_GEMS_PER_CHUNK;
 
-// Global building and gem arrays
-extern Building buildings[MAX_BUILDINGS];
+// Global building and gem slabs
+// Chunk (cx, cz) lives in window slot city_window_slot(cx, cz) and owns the
+// MAX_*_PER_CHUNK entries of each array starting at slot * MAX_*_PER_CHUNK;
+// only the first building / gem count of them are live
+extern BuildingStore buildings;
 extern Gem3D gems_3d[MAX_GEMS_3D];
 extern int active_building_count;
+extern int active_gem_count;
 
 // City generation seed
 extern uint32_t city_seed;
 
-// Current loaded chunk range
-extern int city_chunk_left;
-extern int city_chunk_right;
+// Chunk the loaded window is centred on, and its radius in chunks
+extern int city_chunk_cx;
+extern int city_chunk_cz;
+extern int city_window_radius;
+
+// Chunks and buildings further than this from the camera aren't drawn
+extern float city_draw_distance;
+
+// Objects visited by the last collision / gem pickup query (for profiling)
+extern int city_collision_visits;
+extern int city_gem_visits;
+
+// Chunks and buildings that passed the view cull in the last city_render(),
+// and buildings / gems rejected by the occlusion test this frame
+extern int city_chunks_drawn;
+extern int city_buildings_drawn;
+extern int city_buildings_occluded;
+extern int city_gems_occluded;
+
+// Mesh props (trees, the parked sleigh) drawn by the last city_render()
+extern int city_props_drawn;
+
+// Chunk containing a world position
+inline int city_chunk_of(float world) { return (int)floorf(world / CITY_CHUNK_SIZE); }
+
+// Window slot of a chunk: chunks within CITY_MAX_WINDOW_RADIUS of each other
+// never share one, so moving the window reuses exactly the slots it leaves
+inline int city_window_slot(int cx, int cz) {
+    int sx = cx % CITY_WINDOW_SIDE, sz = cz % CITY_WINDOW_SIDE;
+    if (sx < 0) sx += CITY_WINDOW_SIDE;
+    if (sz < 0) sz += CITY_WINDOW_SIDE;
+    return sz * CITY_WINDOW_SIDE + sx;
+}
 
 // Initialize city system
 void city_init(uint32_t seed);
 
-// Generate buildings for a chunk
-void city_generate_chunk(int chunk_id);
+// Set the loaded window radius (clamped to 1..CITY_MAX_WINDOW_RADIUS) and draw
+// distance; the fog thickens to the draw distance, so the city edge fades out
+void city_set_view_range(int window_radius, float draw_distance);
 
-// Remove buildings from a chunk
-void city_remove_chunk(int chunk_id);
+// Generate buildings for a chunk into its window slot
+// Whatever chunk held the slot must have been removed first
+void city_generate_chunk(int cx, int cz);
+
+// Remove buildings from a chunk (no-op if it isn't live)
+void city_remove_chunk(int cx, int cz);
 
 // Update loaded chunks based on camera position
-void city_update_chunks(float camera_x);
+// Chunks outside the window are unloaded, missing ones are generated nearest
+// first within budget_us; only the camera's own chunk is ever generated synchronously
+void city_update_chunks(float camera_x, float camera_z, uint32_t budget_us = CITY_STREAM_BUDGET_US);
+
+// Streaming state of a chunk (CHUNK_FREE if neither live nor streaming)
+ChunkState city_chunk_state(int cx, int cz);
+
+// True if a world position is on a street tile
+bool city_is_street(float x, float z);
+
+// Start the frame's occlusion map with the nearest large buildings in view
+// (call after the camera is set, before anything is tested against it)
+void city_build_occluders();
+
+// Render the floor tiles around a position (streets, checkered blocks)
+void city_render_floor(float x, float z);
 
-// Render all visible buildings
+// Render the buildings and props of chunks in view (culled per chunk, then per
+// building / prop, then against the occlusion map)
 void city_render();
 
 // Render all visible gems (fb = framebuffer to draw to, nullptr = use pen/pixel)
@@ -67,3 +165,56 @@ int city_collect_gem(float player_x, float player_z, float collect_radius);
 
 // Simple deterministic random for city generation
 uint32_t city_random(uint32_t& seed);
+
+// Counter-based random for city generation: a stateless hash of
+// (seed, chunk, tile, attribute), so any tile can be generated on its own,
+// in any order, on either core. Integer-only, so host and device agree.
+enum CityAttribute : uint32_t {
+    CITY_ATTR_GEM_PRESENT = 0,
+    CITY_ATTR_GEM_X,
+    CITY_ATTR_GEM_Z,
+    CITY_ATTR_GEM_TYPE,
+    CITY_ATTR_BUILDING_PRESENT = 8,
+    CITY_ATTR_BUILDING_WIDTH,
+    CITY_ATTR_BUILDING_DEPTH,
+    CITY_ATTR_BUILDING_HEIGHT,
+    CITY_ATTR_BUILDING_COLOR,
+    CITY_ATTR_PROP_PRESENT = 16,
+};
+
+constexpr uint32_t city_hash_mix(uint32_t x) {
+    x ^= x >> 16; x *= 0x7FEB352Du;
+    x ^= x >> 15; x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+constexpr uint32_t city_hash(uint32_t seed, int32_t chunk, uint32_t tile, uint32_t attribute) {
+    return city_hash_mix(city_hash_mix(city_hash_mix(seed ^ ((uint32_t)chunk * 0x9E3779B9u))
+                                       ^ (tile * 0x85EBCA6Bu)) ^ (attribute * 0xC2B2AE35u));
+}
+
+// Hash key of chunk (cx, cz); tiles within it are numbered tz * CITY_CHUNK_WIDTH + tx
+constexpr int32_t city_chunk_key(int cx, int cz) {
+    return (int32_t)(((uint32_t)cx * 0x8DA6B343u) ^ ((uint32_t)cz * 0xD8163841u));
+}
+
+// 15-bit value, same range as city_random
+constexpr uint32_t city_random_at(uint32_t seed, int32_t chunk, uint32_t tile, uint32_t attribute) {
+    return (city_hash(seed, chunk, tile, attribute) >> 16) & 0x7FFF;
+}
+
+// Structure-of-arrays building parameters for a whole chunk, one entry per
+// building site in tile order; present[i] marks real ones
+struct ChunkBuildingParams {
+    uint8_t present[CITY_BUILDING_SITES];
+    int16_t x[CITY_BUILDING_SITES];
+    int16_t z[CITY_BUILDING_SITES];
+    int16_t half_width[CITY_BUILDING_SITES];
+    int16_t half_depth[CITY_BUILDING_SITES];
+    int16_t height[CITY_BUILDING_SITES];
+    uint8_t color[CITY_BUILDING_SITES];   // Index into the building/roof palettes
+};
+
+// Fill building parameters for every site of a chunk in one branch-free loop
+void city_generate_building_params(int cx, int cz, ChunkBuildingParams& out);
@@ -4,6 +4,11 @@
 #include "render3d.hpp"
 #include "rasterizer.hpp"
 #include "city.hpp"
+#include "sprite.hpp"
+#include "images.hpp"
+#include "texture.hpp"
+#include "benchmark.hpp"
+#include "resolution.hpp"
 #include <cstdlib>
 #include <cmath>
 #include <cstring>
@@ -28,9 +33,13 @@ const float MOVE_SPEED = 0.01f;
 const float FRICTION = 0.95f;
 const float TURN_SPEED = 0.03f;
 const float PLAYER_RADIUS = 0.5f;
+const float CHICKEN_BILLBOARD_SIZE = 0.19f;  // ~2 world units tall (16 px sprite)
 
+#if !RASTER_INDEXED_COLOR
+// Second colour buffer for Core 1 (indexed mode renders into the rasterizer's index buffer)
 static color_t framebuffer[SCREEN_W * SCREEN_H] __attribute__ ((aligned (4))) = { };
 static buffer_t *FRAMEBUFFER = nullptr;
+#endif
 
 static volatile uint32_t core1_time = 0;
 static volatile bool core1_initialized = false;
@@ -39,8 +48,39 @@ static volatile bool core1_initialized = false;
 static uint32_t core0_time_us = 0;
 static uint32_t core1_time_us = 0;
 static uint32_t last_triangle_count = 0;
+static uint32_t last_overdraw_tenths = 0;  // Of Core 1's last frame (visibility buffer only)
+
+// Sent to Core 1 instead of a triangle count when the list matches the last
+// one rendered: it renders nothing and the last frame is shown again
+static const uint32_t CORE1_SKIP_FRAME = 0xFFFFFFFF;
+static bool frame_skipped = false;  // Core 1's current frame is a reused one
 static const uint32_t TARGET_FRAME_US = 16667; // 60 FPS = 16.667ms
 
+// Dynamic resolution (resolution.hpp) driven by Core 1's time; 0 keeps the
+// full resolution and only tracks the jitter
+#define DYNAMIC_RESOLUTION 1
+static ResolutionState resolution = {};
+
+// View range: chunks loaded around the player and the draw distance (the fog
+// thickens up to it). Shorter ranges cut triangles and fill, e.g. a draw
+// distance of 32 draws about a quarter fewer triangles than 50.
+static const int VIEW_WINDOW_RADIUS = CITY_MAX_WINDOW_RADIUS;
+static const float VIEW_DRAW_DISTANCE = CITY_DRAW_DISTANCE;
+
+// Benchmark mode: run benchmarks at startup and show their results instead
+// of running the game. 1 = seeded scenes (image error, times), 2 = synthetic
+// rasterizer sweep (time per triangle and per pixel), 3 = rasterizer
+// backends side by side on each scene's last frame
+#define BENCHMARK_MODE 0
+#if BENCHMARK_MODE == 1
+static BenchmarkResult benchmark_results[BENCHMARK_SCENES];
+static bool benchmark_passed = false;
+#elif BENCHMARK_MODE == 2
+static StressResult stress_results[BENCHMARK_STRESS_SWEEP];
+#elif BENCHMARK_MODE == 3
+static BackendComparison backend_results[BENCHMARK_SCENES];
+#endif
+
 static void draw_chicken_billboard(int cx, int cy, float scale, uint8_t depth, color_t* fb);
 
 static void core1_entry() {
@@ -49,8 +89,16 @@ static void core1_entry() {
 
     while (1) {
         uint32_t num_triangles = multicore_fifo_pop_blocking();
+        if (num_triangles == CORE1_SKIP_FRAME) {
+            multicore_fifo_push_blocking(0);
+            continue;
+        }
         uint32_t start_time = time_us();
+#if RASTER_INDEXED_COLOR
+        rasterizer_render_indexed(num_triangles);
+#else
         rasterizer_render_to_buffer(num_triangles, FRAMEBUFFER->data);
+#endif
         uint32_t end_time = time_us();
         core1_time = end_time - start_time;
         multicore_fifo_push_blocking(core1_time);
@@ -60,13 +108,27 @@ static void core1_entry() {
 static void render_sync() {
     // Wait for Core 1 to finish the previous frame (blocking)
     uint32_t result_time = multicore_fifo_pop_blocking();
-    core1_time_us = result_time;
 
+    // A reused frame says nothing about how long rendering takes, so the HUD
+    // and the controller keep the last rendered frame's time
+    if (!frame_skipped) {
+        core1_time_us = result_time;
+        resolution_update(resolution, core1_time_us, TARGET_FRAME_US, DYNAMIC_RESOLUTION);
+
+        // Core 1 resets its stats when it starts the next list
+        last_overdraw_tenths = rasterizer_overdraw_tenths(rasterizer_get_stats());
+    }
+
+#if RASTER_INDEXED_COLOR
+    // Expand Core 1's palette indices into SCREEN (before the palette is swapped)
+    rasterizer_expand_to_buffer(SCREEN->data);
+#else
     // Swap framebuffers - display what Core 1 just rendered
     buffer_t *TEMP_FB = SCREEN;
     SCREEN = FRAMEBUFFER;
     FRAMEBUFFER = TEMP_FB;
     target(SCREEN);
+#endif
 
     // Swap depth buffers - Core 0 can now read from what Core 1 just wrote
     render3d_swap_depth_buffers();
@@ -76,11 +138,40 @@ static void render_sync() {
 
     // Swap triangle lists and send new work to Core 1
     rasterizer_swap_lists();
+    frame_skipped = rasterizer_list_unchanged();
+    if (frame_skipped) {
+        // Core 1 would redraw the frame now on SCREEN, so copy that (and its
+        // depth) where Core 1 would have put it, before billboards and the
+        // HUD are drawn on top; next frame only those are drawn again.
+        // Indexed mode re-expands Core 1's untouched index buffer instead.
+#if !RASTER_INDEXED_COLOR
+        memcpy(FRAMEBUFFER->data, SCREEN->data, SCREEN_W * SCREEN_H * sizeof(color_t));
+#endif
+        memcpy(depth_buffer_render, depth_buffer_display, DEPTH_WIDTH * DEPTH_HEIGHT);
+        multicore_fifo_push_blocking(CORE1_SKIP_FRAME);
+        return;
+    }
     multicore_fifo_push_blocking(last_triangle_count);
 }
 
 void init() {
+#if !RASTER_INDEXED_COLOR
     FRAMEBUFFER = buffer(SCREEN_W, SCREEN_H, framebuffer);
+#endif
+    texture_init();
+#if BENCHMARK_MODE
+    // Before Core 1 starts, so the rasterizer is free
+    render3d_init();
+#if BENCHMARK_MODE == 1
+    benchmark_passed = benchmark_run(SCREEN->data, benchmark_results);
+#elif BENCHMARK_MODE == 3
+    benchmark_compare_backends(SCREEN->data, backend_results);
+#else
+    for (int i = 0; i < BENCHMARK_STRESS_SWEEP; i++) {
+        benchmark_stress(benchmark_stress_sweep[i], SCREEN->data, stress_results[i]);
+    }
+#endif
+#endif
     multicore_launch_core1(core1_entry);
     while (!core1_initialized) { tight_loop_contents(); }
 
@@ -93,6 +184,7 @@ void init() {
 
     render3d_init();
     city_init(12345);
+    city_set_view_range(VIEW_WINDOW_RADIUS, VIEW_DRAW_DISTANCE);
 
     player.x = 5.0f; player.y = 0.0f; player.z = 0.0f;
     player.vx = 0.0f; player.vz = 0.0f;
@@ -104,6 +196,9 @@ void init() {
 }
 
 void update(uint32_t tick) {
+#if BENCHMARK_MODE
+    return;
+#endif
     float prev_x = player.x;
     float prev_z = player.z;
 
@@ -127,9 +222,6 @@ void update(uint32_t tick) {
     player.x += player.vx;
     player.z += player.vz;
 
-    if (player.z < -2.5f) player.z = -2.5f;
-    if (player.z > 2.5f) player.z = 2.5f;
-
     if (city_check_collision(player.x, player.z, PLAYER_RADIUS)) {
         player.x = prev_x;
         player.z = prev_z;
@@ -137,55 +229,98 @@ void update(uint32_t tick) {
         player.vz = 0;
     }
 
-    if (player.x < 1.0f) { player.x = 1.0f; player.vx = 0; }
-
     float speed = sqrtf(player.vx * player.vx + player.vz * player.vz);
     if (speed > 0.01f) {
         player.anim_timer += (uint32_t)(speed * 1000);
         if (player.anim_timer > 200) {
             player.anim_timer = 0;
-            player.anim_frame = 1 - player.anim_frame;
+            player.anim_frame = (player.anim_frame + 1) % CHICKEN_FRAMES;
         }
         player.facing_right = player.vx > 0 || (player.vx == 0 && forward_x > 0);
     }
 
-    city_update_chunks(player.x);
+    city_update_chunks(player.x, player.z);
     int points = city_collect_gem(player.x, player.z, 1.5f);
     score += points;
 }
 
+#if BENCHMARK_MODE == 1
+// Results over the last benchmark frame: one line of times, one of image error per scene
+static void draw_benchmark_results() {
+    pen(0, 0, 0);
+    frect(0, 0, SCREEN_W, 12 + BENCHMARK_SCENES * 16);
+    pen(15, 15, 15);
+    text(benchmark_passed ? "Benchmark: PASS" : "Benchmark: FAIL", 2, 2);
+    for (int i = 0; i < BENCHMARK_SCENES; i++) {
+        const BenchmarkResult& result = benchmark_results[i];
+        if (result.image_ok && result.time_ok) pen(4, 15, 4);
+        else pen(15, 4, 4);
+        int y = 12 + i * 16;
+        text(str((int32_t)i) + " B:" + str((int32_t)result.build_us) +
+             " R:" + str((int32_t)result.raster_us) + (result.time_ok ? "" : " SLOW"), 2, y);
+        text("  E:" + str((int32_t)result.max_error) + " Bad:" + str((int32_t)result.bad_cells) +
+             (result.image_ok ? "" : " IMG"), 2, y + 8);
+    }
+}
+#elif BENCHMARK_MODE == 2
+// One line per workload: leg x overdraw, depth order (Random / Front first /
+// Back first) and shading (g = Gouraud, t = textured), then ns per triangle and per pixel
+static void draw_benchmark_results() {
+    pen(0, 0, 0);
+    frect(0, 0, SCREEN_W, 12 + BENCHMARK_STRESS_SWEEP * 8);
+    pen(15, 15, 15);
+    text("Leg Od    ns/tri ns/px", 2, 2);
+    for (int i = 0; i < BENCHMARK_STRESS_SWEEP; i++) {
+        const StressWorkload& workload = benchmark_stress_sweep[i];
+        const StressResult& result = stress_results[i];
+        const char* order = workload.order == STRESS_FRONT_TO_BACK ? "F" :
+                            workload.order == STRESS_BACK_TO_FRONT ? "B" : "R";
+        text(str((int32_t)workload.leg) + "x" + str((int32_t)workload.overdraw) + " " + order +
+             (workload.shading == STRESS_GOURAUD ? "g " : workload.shading == STRESS_TEXTURED ? "t " : " ") +
+             str((int32_t)result.ns_per_triangle) +
+             " " + str((int32_t)result.ns_per_pixel), 2, 12 + i * 8);
+    }
+}
+#elif BENCHMARK_MODE == 3
+// One line per scene: triangles, edge and scanline raster times, and whether
+// the scanline frame matched the edge one (= bit for bit, else the worst cell error)
+static void draw_benchmark_results() {
+    pen(0, 0, 0);
+    frect(0, 0, SCREEN_W, 12 + BENCHMARK_SCENES * 8);
+    pen(15, 15, 15);
+    text("Sc Tri  Edge  Scan", 2, 2);
+    for (int i = 0; i < BENCHMARK_SCENES; i++) {
+        const BackendComparison& result = backend_results[i];
+        if (result.identical) pen(4, 15, 4);
+        else pen(15, 4, 4);
+        text(str((int32_t)i) + " " + str((int32_t)result.triangles) +
+             " " + str((int32_t)result.raster_us[RASTER_BACKEND_EDGE]) +
+             " " + str((int32_t)result.raster_us[RASTER_BACKEND_SCANLINE]) +
+             (result.identical ? " =" : " E:" + str((int32_t)result.max_error)), 2, 12 + i * 8);
+    }
+}
+#endif
+
 void draw(uint32_t tick) {
+#if BENCHMARK_MODE
+    draw_benchmark_results();
+    return;
+#endif
     uint32_t frame_start = time_us();
     render_sync();
     render3d_begin_frame();
+    render3d_set_viewport(resolution_size(resolution), resolution_size(resolution));
 
     // Sky gradient is now drawn by Core 1 in rasterizer_render_to_buffer
 
     render3d_third_person_camera(player.x, player.y, player.z, player.yaw);
+    city_build_occluders();
 
-    {
-        int player_grid_x = (int)floorf(player.x / 4.0f);
-        int player_grid_z = (int)floorf(player.z / 4.0f);
-        for (int gx = -5; gx <= 5; gx++) {
-            for (int gz = -5; gz <= 5; gz++) {
-                int grid_x = player_grid_x + gx;
-                int grid_z = player_grid_z + gz;
-                float tile_x = grid_x * 4.0f + 2.0f;
-                float tile_z = grid_z * 4.0f + 2.0f;
-                bool dark = ((grid_x + grid_z) & 1) == 0;
-                uint8_t cr = dark ? 60 : 80;
-                uint8_t cg = dark ? 60 : 80;
-                uint8_t cb = dark ? 70 : 90;
-                render3d_cube(tile_x, -0.5f, tile_z, 4.0f, 0.5f, 4.0f, cr, cg, cb, cr, cg, cb);
-            }
-        }
-    }
-
+    city_render_floor(player.x, player.z);
     city_render();
     // Render gems to SCREEN (which contains Core 1's rendered geometry)
     city_render_gems(time(), SCREEN->data);
-    // TODO: Re-enable chicken billboard once colors are fixed
-    // render3d_billboard(player.x, player.y + 0.5f, player.z, draw_chicken_billboard, 1.5f, SCREEN->data);
+    render3d_billboard(player.x, player.y, player.z, draw_chicken_billboard, CHICKEN_BILLBOARD_SIZE, SCREEN->data);
     render3d_end_frame();
 
     // Measure Core 0 time (scene building)
@@ -194,6 +329,7 @@ void draw(uint32_t tick) {
     // Calculate CPU percentages
     int cpu0_pct = (int)(core0_time_us * 100 / TARGET_FRAME_US);
     int cpu1_pct = (int)(core1_time_us * 100 / TARGET_FRAME_US);
+    int jitter_pct = (int)(resolution.time_dev_us * 100 / TARGET_FRAME_US);
 
     // Top bar - Score
     pen(0, 0, 0); alpha(11);
@@ -201,6 +337,10 @@ void draw(uint32_t tick) {
     alpha();
     pen(15, 15, 15);
     text("Score: " + str((int32_t)score), 2, 2);
+#if RASTER_VISIBILITY_BUFFER
+    text("Od:" + str((int32_t)(last_overdraw_tenths / 10)) + "." + str((int32_t)(last_overdraw_tenths % 10)),
+         SCREEN_W - 36, 2);
+#endif
 
     // Bottom bar - Performance stats
     pen(0, 0, 0); alpha(10);
@@ -216,53 +356,12 @@ void draw(uint32_t tick) {
     text("C0:" + str((int32_t)cpu0_pct) + "% C1:" + str((int32_t)cpu1_pct) + "%", 2, SCREEN_H - 16);
 
     pen(10, 10, 12);
-    text("Tri:" + str((int32_t)last_triangle_count), 2, SCREEN_H - 8);
+    text("Tri:" + str((int32_t)last_triangle_count) +
+         " R:" + str((int32_t)resolution_size(resolution)) +
+         " J:" + str((int32_t)jitter_pct) + "%", 2, SCREEN_H - 8);
 }
 
 static void draw_chicken_billboard(int cx, int cy, float scale, uint8_t depth, color_t* fb) {
-    if (scale < 0.2f) return;
-
-    auto put_scaled_pixel = [&](int px, int py, uint8_t r, uint8_t g, uint8_t b) {
-        int fx = player.facing_right ? px : (7 - px);
-        int x1 = cx + (int)((fx - 4) * scale);
-        int y1 = cy + (int)((py - 4) * scale);
-        int x2 = x1 + (int)(scale) + 1;
-        int y2 = y1 + (int)(scale) + 1;
-        for (int yy = y1; yy < y2; yy++) {
-            for (int xx = x1; xx < x2; xx++) {
-                if (xx >= 0 && xx < SCREEN_W && yy >= 0 && yy < SCREEN_H) {
-                    if (depth_test(xx, yy, depth)) {
-                        if (fb) {
-                            fb[yy * SCREEN_W + xx] = rgb_to_color(r * 17, g * 17, b * 17);
-                        } else {
-                            pen(r, g, b);
-                            pixel(xx, yy);
-                        }
-                    }
-                }
-            }
-        }
-    };
-
-    put_scaled_pixel(2, 0, 15, 3, 3); put_scaled_pixel(3, 0, 15, 3, 3);
-    put_scaled_pixel(1, 1, 15, 15, 15); put_scaled_pixel(2, 1, 15, 15, 15);
-    put_scaled_pixel(3, 1, 15, 15, 15); put_scaled_pixel(4, 1, 15, 15, 15);
-    put_scaled_pixel(1, 2, 15, 15, 15); put_scaled_pixel(2, 2, 0, 0, 0);
-    put_scaled_pixel(3, 2, 15, 15, 15); put_scaled_pixel(0, 2, 15, 10, 0);
-    put_scaled_pixel(1, 3, 15, 3, 3); put_scaled_pixel(2, 3, 15, 15, 15);
-    put_scaled_pixel(3, 3, 15, 15, 15); put_scaled_pixel(4, 3, 15, 13, 6);
-    put_scaled_pixel(2, 4, 15, 15, 15); put_scaled_pixel(3, 4, 15, 15, 15);
-    put_scaled_pixel(4, 4, 15, 15, 15); put_scaled_pixel(5, 4, 15, 15, 15);
-    put_scaled_pixel(6, 4, 15, 13, 6);
-    put_scaled_pixel(2, 5, 15, 15, 15); put_scaled_pixel(3, 5, 15, 15, 15);
-    put_scaled_pixel(4, 5, 15, 15, 15); put_scaled_pixel(5, 5, 15, 15, 15);
-    put_scaled_pixel(6, 5, 15, 13, 6); put_scaled_pixel(7, 5, 15, 13, 6);
-
-    if (player.anim_frame == 0) {
-        put_scaled_pixel(3, 6, 15, 10, 0); put_scaled_pixel(4, 6, 15, 10, 0);
-        put_scaled_pixel(3, 7, 15, 10, 0); put_scaled_pixel(4, 7, 15, 10, 0);
-    } else {
-        put_scaled_pixel(2, 6, 15, 10, 0); put_scaled_pixel(5, 6, 15, 10, 0);
-        put_scaled_pixel(2, 7, 15, 10, 0); put_scaled_pixel(5, 7, 15, 10, 0);
-    }
+    // The sprite faces left
+    sprite_draw(chicken_sprites[player.anim_frame], cx, cy, scale, depth, player.facing_right, fb);
 }
@@ -0,0 +1,73 @@
+#include "mesh.hpp"
+#include <algorithm>
+
+static_assert(RENDER3D_FIXED_ONE % MESH_POSITION_ONE == 0, "mesh bounds convert to render units by a shift");
+
+// Projected vertices of the mesh being drawn (visible = in front of the camera)
+static VertexScreen mesh_screen[MESH_MAX_VERTICES];
+static bool mesh_visible[MESH_MAX_VERTICES];
+
+static inline uint32_t align4(uint32_t offset) { return (offset + 3) & ~3u; }
+
+bool mesh_load(const uint8_t* data, Mesh& mesh) {
+    const MeshHeader* header = (const MeshHeader*)data;
+    mesh.header = nullptr;
+    if (memcmp(header->magic, "MSH1", 4) != 0) return false;
+    if (header->vertex_count > MESH_MAX_VERTICES) return false;
+
+    uint32_t offset = sizeof(MeshHeader);
+    mesh.header = header;
+    mesh.vertices = (const MeshVertex*)(data + offset);
+    offset = align4(offset + header->vertex_count * sizeof(MeshVertex));
+    mesh.faces = (const MeshFace*)(data + offset);
+    offset += header->face_count * sizeof(MeshFace);
+    mesh.colors = data + offset;
+    return true;
+}
+
+bool mesh_render(const Mesh& mesh, int32_t x, int32_t y, int32_t z, float yaw, float max_distance) {
+    if (!mesh.header) return false;
+    const MeshHeader& header = *mesh.header;
+    const int scale = RENDER3D_FIXED_ONE / MESH_POSITION_ONE;
+
+    // Cull with the bounds' footprint radius, so it holds at any yaw
+    int32_t reach = 0;
+    for (int axis = 0; axis < 3; axis += 2) {
+        reach = std::max(reach, (int32_t)std::max(abs(header.bounds_min[axis]), abs(header.bounds_max[axis])));
+    }
+    float radius = (float)reach * 1.415f / MESH_POSITION_ONE;
+    float fx = (float)x / RENDER3D_FIXED_ONE, fy = (float)y / RENDER3D_FIXED_ONE, fz = (float)z / RENDER3D_FIXED_ONE;
+    if (!render3d_visible_xz(fx - radius, fz - radius, fx + radius, fz + radius, max_distance)) return false;
+    float bottom = (float)header.bounds_min[1] / MESH_POSITION_ONE;
+    float height = (float)(header.bounds_max[1] - header.bounds_min[1]) / MESH_POSITION_ONE;
+    if (render3d_box_occluded(fx, fy + bottom, fz, 2 * radius, height, 2 * radius)) return false;
+
+    // Dequantize, turn and project every vertex once
+    int32_t c = (int32_t)(cosf(yaw) * RENDER3D_FIXED_ONE), s = (int32_t)(sinf(yaw) * RENDER3D_FIXED_ONE);
+    int32_t extent[3], origin[3];
+    for (int axis = 0; axis < 3; axis++) {
+        origin[axis] = header.bounds_min[axis] * scale;
+        extent[axis] = (header.bounds_max[axis] - header.bounds_min[axis]) * scale;
+    }
+    for (int i = 0; i < header.vertex_count; i++) {
+        const MeshVertex& v = mesh.vertices[i];
+        int32_t lx = origin[0] + v.x * extent[0] / 255;
+        int32_t ly = origin[1] + v.y * extent[1] / 255;
+        int32_t lz = origin[2] + v.z * extent[2] / 255;
+        int32_t wx = x + (lx * c - lz * s) / RENDER3D_FIXED_ONE;
+        int32_t wz = z + (lx * s + lz * c) / RENDER3D_FIXED_ONE;
+        mesh_visible[i] = render3d_project_fx(wx, y + ly, wz, mesh_screen[i]);
+    }
+
+    for (int i = 0; i < header.face_count; i++) {
+        const MeshFace& face = mesh.faces[i];
+        if (!mesh_visible[face.a] || !mesh_visible[face.b] || !mesh_visible[face.c]) continue;
+        const uint8_t* rgb = mesh.colors + face.color * 3;
+        VertexScreen v0 = mesh_screen[face.a], v1 = mesh_screen[face.b], v2 = mesh_screen[face.c];
+        v0.r = v1.r = v2.r = rgb[0];
+        v0.g = v1.g = v2.g = rgb[1];
+        v0.b = v1.b = v2.b = rgb[2];
+        render3d_triangle(v0, v1, v2);
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "render3d.hpp"
+
+// Baked meshes (tools/bake_meshes.py): a header, positions quantized to 8 bits
+// within the mesh bounds, triangle faces with one colour each and the colour
+// list. Meshes are read in place from the baked const data (flash on the
+// device), so loading one costs no RAM beyond the Mesh view.
+
+constexpr int MESH_POSITION_ONE = 256;  // Bounds units per world unit
+constexpr int MESH_MAX_VERTICES = 128;  // Projected per draw into a static scratch array
+
+struct MeshHeader {
+    char magic[4];           // "MSH1"
+    uint16_t vertex_count;
+    uint16_t face_count;
+    uint8_t color_count;
+    uint8_t _pad[3];
+    int16_t bounds_min[3];   // MESH_POSITION_ONE units, relative to the mesh origin
+    int16_t bounds_max[3];
+};
+static_assert(sizeof(MeshHeader) == 24, "MeshHeader must match the baked layout");
+
+struct MeshVertex {
+    uint8_t x, y, z;         // 0 = bounds_min, 255 = bounds_max
+};
+
+struct MeshFace {
+    uint8_t a, b, c;         // Vertex indices, counter-clockwise from the front
+    uint8_t color;           // Index into the colour list
+};
+
+// View of a baked mesh (pointers into its data)
+struct Mesh {
+    const MeshHeader* header;
+    const MeshVertex* vertices;
+    const MeshFace* faces;
+    const uint8_t* colors;   // r, g, b per colour
+};
+
+// Point a Mesh at baked data (4-byte aligned); false if it isn't a mesh or
+// has more than MESH_MAX_VERTICES, leaving the Mesh empty (null header)
+bool mesh_load(const uint8_t* data, Mesh& mesh);
+
+// Render a mesh with its origin at a fixed-point world position (RENDER3D_FIXED_ONE
+// units), turned by yaw radians about y. Culled against the view, max_distance
+// and the occlusion map; returns false if nothing was submitted (or the
+// mesh is empty).
+bool mesh_render(const Mesh& mesh, int32_t x, int32_t y, int32_t z, float yaw, float max_distance);
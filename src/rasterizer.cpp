@@ -20,12 +20,133 @@ static RasterTriangle* triangle_list_next = triangle_list2;
 static volatile uint32_t triangle_count_current = 0;
 static uint32_t triangle_count_next = 0;
 
-// Forward declaration
-static void rasterize_single_triangle(const RasterTriangle& tri, color_t* buffer);
+// Viewport each list was projected into (travels with the list on swap)
+static int32_t viewport_width_current = RASTER_SCREEN_WIDTH;
+static int32_t viewport_height_current = RASTER_SCREEN_HEIGHT;
+static int32_t viewport_width_next = RASTER_SCREEN_WIDTH;
+static int32_t viewport_height_next = RASTER_SCREEN_HEIGHT;
+
+// Texture coordinates of each list's textured triangles (swapped with the lists)
+static RasterTexCoords texcoord_list1[MAX_TEXTURED_TRIANGLES];
+static RasterTexCoords texcoord_list2[MAX_TEXTURED_TRIANGLES];
+static RasterTexCoords* texcoord_list_current = texcoord_list1;
+static RasterTexCoords* texcoord_list_next = texcoord_list2;
+static uint32_t texcoord_count_next = 0;
+
+// Texture slots
+struct RasterTexture {
+    const color_t* texels;
+    uint8_t size_log2;
+};
+static RasterTexture textures[RASTER_MAX_TEXTURES];
+
+// Per-frame colour palette (double-buffered with the triangle lists)
+// Open-addressed by colour hash, so the slot index is the palette index
+// Colours that didn't fit once it filled up are remembered with the nearest
+// entry they were given, direct-mapped by the same hash, so each costs one
+// probe chain and nearest-colour scan per frame
+#define PALETTE_MISS_SLOTS 64
+
+struct RasterPalette {
+    uint32_t keys[RASTER_PALETTE_SIZE];    // 0x01RRGGBB, 0 = empty slot
+    color_t colors[RASTER_PALETTE_SIZE];   // Pre-converted for flat fills
+    uint32_t count;
+    uint32_t miss_keys[PALETTE_MISS_SLOTS];   // 0 = empty
+    uint8_t miss_index[PALETTE_MISS_SLOTS];
+};
+
+// Stop inserting before the table is full so probing stays short
+#define PALETTE_MAX_FILL (RASTER_PALETTE_SIZE * 7 / 8)
+
+// Key stored in slot 0 so it is never handed out (it can't match a real colour)
+#define PALETTE_RESERVED_KEY 0xFF000000
+
+static RasterPalette palette1;
+static RasterPalette palette2;
+static RasterPalette* palette_current = &palette1;
+static RasterPalette* palette_next = &palette2;
+
+#if RASTER_INDEXED_COLOR
+// Palette-index framebuffer written by Core 1 (0 = sky)
+static uint8_t index_buffer[RASTER_SCREEN_WIDTH * RASTER_SCREEN_HEIGHT];
+#endif
+
+#if RASTER_VISIBILITY_BUFFER
+// Triangle index (in the "current" list) of each viewport pixel's nearest
+// surface, written by the first pass of rasterizer_render_to_buffer
+static uint16_t visibility_buffer[RASTER_SCREEN_WIDTH * RASTER_SCREEN_HEIGHT];
+#endif
+
+// Visibility buffer entry of a pixel no triangle covers
+#define VISIBILITY_NONE 0xFFFF
+
+// 4x4 ordered dither thresholds (0..1023) for indexed Gouraud
+static const int16_t dither_thresholds[4][4] = {
+    {  32, 544, 160, 672 },
+    { 800, 288, 928, 416 },
+    { 224, 736,  96, 608 },
+    { 992, 480, 864, 352 },
+};
+
+// Per-class stats of the last rendered list
+static RasterStats raster_stats;
+
+// Backend for medium and large triangles (read by Core 1 per triangle)
+static RasterBackend raster_backend = RASTER_DEFAULT_BACKEND;
+
+#if RASTER_FRAME_SKIP
+// Hash of the current list, and whether it matched the one before it
+static uint32_t list_hash_current = 0;
+static bool list_unchanged = false;
+#endif
+
+// Forward declarations
+static RasterClass rasterize_single_triangle(const RasterTriangle& tri, const RasterPalette& palette,
+                                             const RasterTexCoords* texcoords, color_t* buffer, uint8_t* indices,
+                                             uint16_t* visibility, uint16_t index,
+                                             int32_t viewport_width, int32_t viewport_height);
+static void upscale_viewport(color_t* buffer, int32_t viewport_width, int32_t viewport_height);
+#if RASTER_VISIBILITY_BUFFER
+static void resolve_visibility(color_t* buffer, int32_t viewport_width, int32_t viewport_height);
+#endif
+
+// Rasterize the "current" list, adding each triangle's time to its class.
+// One timer read per triangle, chained, keeps the per-class sums unbiased
+// even though most triangles take less than a microsecond.
+static void rasterize_current_list(uint32_t count, color_t* buffer, uint8_t* indices, uint16_t* visibility,
+                                   int32_t viewport_width, int32_t viewport_height) {
+    memset(&raster_stats, 0, sizeof(raster_stats));
+    uint32_t last = time_us();
+    for (uint32_t i = 0; i < count; i++) {
+        RasterClass cls = rasterize_single_triangle(triangle_list_current[i], *palette_current,
+                                                    texcoord_list_current, buffer, indices,
+                                                    visibility, (uint16_t)i, viewport_width, viewport_height);
+        uint32_t now = time_us();
+        raster_stats.triangles[cls]++;
+        raster_stats.time_us[cls] += now - last;
+        last = now;
+    }
+}
+
+// Sky gradient colour for a full-screen row
+static inline color_t sky_color(int y) {
+    uint8_t r, g, b;
+    rasterizer_sky_rgb(y, r, g, b);
+    return rgb_to_color(r, g, b);
+}
+
+static void reset_palette(RasterPalette* palette) {
+    memset(palette->keys, 0, sizeof(palette->keys));
+    memset(palette->miss_keys, 0, sizeof(palette->miss_keys));
+    palette->keys[0] = PALETTE_RESERVED_KEY;
+    palette->count = 1;
+}
 
 void rasterizer_init() {
     triangle_count_current = 0;
     triangle_count_next = 0;
+    reset_palette(palette_current);
+    reset_palette(palette_next);
 }
 
 bool rasterizer_submit_triangle(const RasterTriangle& tri) {
@@ -36,23 +157,89 @@ bool rasterizer_submit_triangle(const RasterTriangle& tri) {
     return true;
 }
 
+bool rasterizer_submit_textured_triangle(RasterTriangle tri, const RasterTexCoords& coords) {
+    tri.c3 = tri.c1;
+    if (texcoord_count_next >= MAX_TEXTURED_TRIANGLES || !textures[coords.texture].texels) {
+        tri.c2 = tri.c1;
+        tri.flags = RASTER_FLAG_FLAT;
+        return rasterizer_submit_triangle(tri);
+    }
+    tri.c2 = (uint8_t)texcoord_count_next;
+    tri.flags = RASTER_FLAG_FLAT | RASTER_FLAG_TEXTURED;
+    if (!rasterizer_submit_triangle(tri)) return false;
+    texcoord_list_next[texcoord_count_next++] = coords;
+    return true;
+}
+
+void rasterizer_set_texture(uint8_t slot, const color_t* texels, uint8_t size_log2) {
+    if (slot >= RASTER_MAX_TEXTURES) return;
+    textures[slot].texels = texels;
+    textures[slot].size_log2 = size_log2;
+}
+
+uint8_t rasterizer_palette_index(uint8_t r, uint8_t g, uint8_t b) {
+    RasterPalette* palette = palette_next;
+    uint32_t key = 0x01000000 | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    uint32_t hash = key * 2654435761u;
+    uint32_t slot = hash >> 24;
+
+    // Once full, a colour seen before that didn't fit is answered without probing
+    bool full = palette->count >= PALETTE_MAX_FILL;
+    uint32_t miss_slot = (hash >> 18) & (PALETTE_MISS_SLOTS - 1);
+    if (full && palette->miss_keys[miss_slot] == key) return palette->miss_index[miss_slot];
+
+    // Linear probe; PALETTE_MAX_FILL guarantees an empty slot ends the search
+    while (palette->keys[slot] != 0) {
+        if (palette->keys[slot] == key) return (uint8_t)slot;
+        slot = (slot + 1) & (RASTER_PALETTE_SIZE - 1);
+    }
+
+    if (!full) {
+        palette->keys[slot] = key;
+        palette->colors[slot] = rgb_to_color(r, g, b);
+        palette->count++;
+        return (uint8_t)slot;
+    }
+
+    // Palette full: use the nearest existing colour
+    uint32_t best = 0;
+    int32_t best_dist = INT32_MAX;
+    for (uint32_t i = 0; i < RASTER_PALETTE_SIZE; i++) {
+        uint32_t k = palette->keys[i];
+        if ((k >> 24) != 0x01) continue;
+        int32_t dr = (int32_t)((k >> 16) & 0xFF) - r;
+        int32_t dg = (int32_t)((k >> 8) & 0xFF) - g;
+        int32_t db = (int32_t)(k & 0xFF) - b;
+        int32_t dist = dr * dr + dg * dg + db * db;
+        if (dist < best_dist) { best_dist = dist; best = i; }
+    }
+    palette->miss_keys[miss_slot] = key;
+    palette->miss_index[miss_slot] = (uint8_t)best;
+    return (uint8_t)best;
+}
+
 uint32_t rasterizer_get_triangle_count() {
     return triangle_count_next;
 }
 
 void rasterizer_begin_frame() {
     triangle_count_next = 0;
+    texcoord_count_next = 0;
+    reset_palette(palette_next);
 }
 
 uint32_t rasterizer_end_frame() {
-    // Single-threaded fallback: rasterize synchronously to SCREEN
+    // Single-threaded fallback: rasterize synchronously to SCREEN (no upscaling)
     memset(depth_buffer_render, 0xFF, RASTER_SCREEN_WIDTH * RASTER_SCREEN_HEIGHT);
 
     for (uint32_t i = 0; i < triangle_count_next; i++) {
-        rasterize_single_triangle(triangle_list_next[i], nullptr);
+        rasterize_single_triangle(triangle_list_next[i], *palette_next, texcoord_list_next, nullptr, nullptr,
+                                  nullptr, 0, viewport_width_next, viewport_height_next);
     }
 
     triangle_count_next = 0;
+    texcoord_count_next = 0;
+    reset_palette(palette_next);
     return 0;
 }
 
@@ -60,32 +247,139 @@ bool rasterizer_is_busy() {
     return false;
 }
 
+void rasterizer_set_viewport(int32_t width, int32_t height) {
+    if (width < 1) width = 1;
+    if (width > RASTER_SCREEN_WIDTH) width = RASTER_SCREEN_WIDTH;
+    if (height < 1) height = 1;
+    if (height > RASTER_SCREEN_HEIGHT) height = RASTER_SCREEN_HEIGHT;
+    viewport_width_next = width;
+    viewport_height_next = height;
+}
+
 // === Multicore API ===
 
 void rasterizer_render_to_buffer(uint32_t count, color_t* buffer) {
+    int32_t vw = viewport_width_current;
+    int32_t vh = viewport_height_current;
+
     // Clear depth buffer (Core 1 uses depth_buffer_render)
-    memset(depth_buffer_render, 0xFF, RASTER_SCREEN_WIDTH * RASTER_SCREEN_HEIGHT);
+    memset(depth_buffer_render, 0xFF, vw * vh);
 
+#if RASTER_VISIBILITY_BUFFER
+    // Depth and triangle indices first, then every pixel (sky included) is shaded once
+    memset(visibility_buffer, 0xFF, vw * vh * sizeof(uint16_t));
+    rasterize_current_list(count, buffer, nullptr, visibility_buffer, vw, vh);
+    uint32_t resolve_start = time_us();
+    resolve_visibility(buffer, vw, vh);
+    raster_stats.resolve_us = time_us() - resolve_start;
+#else
     // Clear color buffer with sky gradient
-    for (int y = 0; y < RASTER_SCREEN_HEIGHT; y++) {
-        // Sky gradient (same as in game.cpp but using rgb_to_color)
-        int r = 40 + y / 6;
-        int g = 60 + y / 4;
-        int b = 120 + y / 3;
-        color_t sky_color = rgb_to_color(r, g, b);
-        color_t* row = buffer + y * RASTER_SCREEN_WIDTH;
-        for (int x = 0; x < RASTER_SCREEN_WIDTH; x++) {
-            row[x] = sky_color;
+    for (int y = 0; y < vh; y++) {
+        // Evaluated at the full-screen row so it looks the same at any viewport
+        color_t sky = sky_color(y * RASTER_SCREEN_HEIGHT / vh);
+        color_t* row = buffer + y * vw;
+        for (int x = 0; x < vw; x++) {
+            row[x] = sky;
         }
     }
 
     // Rasterize all triangles from the "current" list
-    for (uint32_t i = 0; i < count; i++) {
-        rasterize_single_triangle(triangle_list_current[i], buffer);
+    rasterize_current_list(count, buffer, nullptr, nullptr, vw, vh);
+#endif
+
+    if (vw != RASTER_SCREEN_WIDTH || vh != RASTER_SCREEN_HEIGHT) {
+        upscale_viewport(buffer, vw, vh);
     }
 }
 
+#if RASTER_INDEXED_COLOR
+void rasterizer_render_indexed(uint32_t count) {
+    int32_t vw = viewport_width_current;
+    int32_t vh = viewport_height_current;
+
+    memset(depth_buffer_render, 0xFF, vw * vh);
+    memset(index_buffer, 0, vw * vh);
+
+    rasterize_current_list(count, nullptr, index_buffer, nullptr, vw, vh);
+
+    // Core 0 billboards depth test against the full-screen depth buffer
+    if (vw != RASTER_SCREEN_WIDTH || vh != RASTER_SCREEN_HEIGHT) {
+        upscale_viewport(nullptr, vw, vh);
+    }
+}
+
+void rasterizer_expand_to_buffer(color_t* buffer) {
+    int32_t vw = viewport_width_current;
+    int32_t vh = viewport_height_current;
+    RasterPalette* palette = palette_current;
+
+    uint8_t src_x[RASTER_SCREEN_WIDTH];
+    for (int32_t x = 0; x < RASTER_SCREEN_WIDTH; x++) {
+        src_x[x] = (uint8_t)(x * vw / RASTER_SCREEN_WIDTH);
+    }
+
+    for (int32_t y = 0; y < RASTER_SCREEN_HEIGHT; y++) {
+        // Slot 0 is the sky; point it at this row's gradient colour
+        palette->colors[0] = sky_color(y);
+        const uint8_t* src = index_buffer + (y * vh / RASTER_SCREEN_HEIGHT) * vw;
+        color_t* dst = buffer + y * RASTER_SCREEN_WIDTH;
+        if (vw == RASTER_SCREEN_WIDTH) {
+            for (int32_t x = 0; x < RASTER_SCREEN_WIDTH; x++) dst[x] = palette->colors[src[x]];
+        } else {
+            for (int32_t x = 0; x < RASTER_SCREEN_WIDTH; x++) dst[x] = palette->colors[src[src_x[x]]];
+        }
+    }
+}
+#endif
+
+const RasterStats& rasterizer_get_stats() {
+    return raster_stats;
+}
+
+void rasterizer_set_backend(RasterBackend backend) {
+    if (backend < RASTER_BACKEND_COUNT) raster_backend = backend;
+}
+
+RasterBackend rasterizer_get_backend() {
+    return raster_backend;
+}
+
+#if RASTER_FRAME_SKIP
+static inline uint32_t hash_word(uint32_t hash, uint32_t word) {
+    return (((hash << 5) | (hash >> 27)) ^ word) * 0x9E3779B1u;
+}
+
+// Everything Core 1's output depends on in the "next" list, one multiply per
+// word (about 6000 words for a city frame)
+static uint32_t hash_next_list() {
+    uint32_t hash = hash_word(2166136261u, (uint32_t)viewport_width_next | ((uint32_t)viewport_height_next << 16));
+    hash = hash_word(hash, triangle_count_next);
+    for (uint32_t i = 0; i < triangle_count_next; i++) {
+        const RasterTriangle& tri = triangle_list_next[i];
+        hash = hash_word(hash, tri.v1);
+        hash = hash_word(hash, tri.v2);
+        hash = hash_word(hash, tri.v3);
+        hash = hash_word(hash, tri.c1 | (tri.c2 << 8) | (tri.c3 << 16) | ((uint32_t)tri.flags << 24));
+    }
+    for (uint32_t i = 0; i < texcoord_count_next; i++) {
+        const RasterTexCoords& coords = texcoord_list_next[i];
+        hash = hash_word(hash, coords.u1 | (coords.v1 << 8) | (coords.u2 << 16) | ((uint32_t)coords.v2 << 24));
+        hash = hash_word(hash, coords.u3 | (coords.v3 << 8) | (coords.texture << 16));
+    }
+    for (uint32_t i = 0; i < RASTER_PALETTE_SIZE; i++) {
+        hash = hash_word(hash, palette_next->keys[i]);
+    }
+    return hash;
+}
+#endif
+
 void rasterizer_swap_lists() {
+#if RASTER_FRAME_SKIP
+    uint32_t hash = hash_next_list();
+    list_unchanged = hash == list_hash_current;
+    list_hash_current = hash;
+#endif
+
     // Swap the triangle list pointers
     RasterTriangle* temp = triangle_list_current;
     triangle_list_current = triangle_list_next;
@@ -94,19 +388,440 @@ void rasterizer_swap_lists() {
     // Transfer the count and reset next
     triangle_count_current = triangle_count_next;
     triangle_count_next = 0;
+
+    // So do its texture coordinates
+    RasterTexCoords* temp_texcoords = texcoord_list_current;
+    texcoord_list_current = texcoord_list_next;
+    texcoord_list_next = temp_texcoords;
+    texcoord_count_next = 0;
+
+    // The palette the list's colour indices refer to goes with it
+    RasterPalette* temp_palette = palette_current;
+    palette_current = palette_next;
+    palette_next = temp_palette;
+    reset_palette(palette_next);
+
+    // The viewport stays with the list it was projected for
+    viewport_width_current = viewport_width_next;
+    viewport_height_current = viewport_height_next;
+}
+
+bool rasterizer_list_unchanged() {
+#if RASTER_FRAME_SKIP
+    return list_unchanged;
+#else
+    return false;
+#endif
+}
+
+// Nearest-neighbour upscale of the packed viewport (stride = viewport_width)
+// to the full screen, in place. Walking backwards is safe because every
+// source index is <= its destination index. buffer may be nullptr (depth only).
+static void upscale_viewport(color_t* buffer, int32_t viewport_width, int32_t viewport_height) {
+    uint8_t src_x[RASTER_SCREEN_WIDTH];
+    for (int32_t x = 0; x < RASTER_SCREEN_WIDTH; x++) {
+        src_x[x] = (uint8_t)(x * viewport_width / RASTER_SCREEN_WIDTH);
+    }
+
+    uint8_t* depth = depth_buffer_render;
+    for (int32_t y = RASTER_SCREEN_HEIGHT - 1; y >= 0; y--) {
+        int32_t src_row = (y * viewport_height / RASTER_SCREEN_HEIGHT) * viewport_width;
+        int32_t dst_row = y * RASTER_SCREEN_WIDTH;
+        for (int32_t x = RASTER_SCREEN_WIDTH - 1; x >= 0; x--) {
+            if (buffer) buffer[dst_row + x] = buffer[src_row + src_x[x]];
+            depth[dst_row + x] = depth[src_row + src_x[x]];
+        }
+    }
+}
+
+// Tiny triangles by their unclipped bounding box
+static inline bool is_tiny(int32_t x_small, int32_t x_large, int32_t y_small, int32_t y_large) {
+    return RASTER_SIZE_DISPATCH && x_large - x_small < RASTER_TINY_SIZE && y_large - y_small < RASTER_TINY_SIZE;
+}
+
+// Lowest and highest x on a row where the edge function a * x + b is >= 0
+// narrow [lo, hi]; lo > hi afterwards means the row misses the triangle
+static inline void clip_span_to_edge(int32_t a, int32_t b, int32_t& lo, int32_t& hi) {
+    if (a > 0) {
+        // x >= ceil(-b / a)
+        int32_t q = b / a;
+        if (b % a != 0 && b < 0) q--;
+        if (-q > lo) lo = -q;
+    } else if (a < 0) {
+        // x <= floor(b / -a)
+        int32_t q = b / -a;
+        if (b % -a != 0 && b < 0) q--;
+        if (q < hi) hi = q;
+    } else if (b < 0) {
+        hi = lo - 1;
+    }
+}
+
+// Packed Gouraud colour: r, b and g lanes of GOURAUD_LANE_BITS from bit 0,
+// each a 4-bit colour level with GOURAUD_FRACTION_BITS below it. A lane is
+// reseeded exactly (rounded down) at a pixel inside the triangle and stepped
+// by its per-pixel change truncated toward zero, so over the drawn pixels it
+// stays between the seed and the exact value, inside 0..15.99 levels. The
+// packed word is then exactly the sum of its in-range lanes, so one add steps
+// all three and no lane ever borrows from or carries into another. The error
+// is under (n + 1) / 64 levels (always downward) n pixels after a seed, so
+// reseeding every GOURAUD_RESEED_PIXELS keeps it under 33 / 64 of a level.
+#define GOURAUD_FRACTION_BITS 6
+#define GOURAUD_LANE_BITS 10
+#define GOURAUD_RESEED_PIXELS 32
+
+static inline uint32_t gouraud_pack(int32_t r, int32_t g, int32_t b) {
+    return (uint32_t)r + ((uint32_t)b << GOURAUD_LANE_BITS) + ((uint32_t)g << (2 * GOURAUD_LANE_BITS));
 }
 
-// Rasterize a single triangle
-static void rasterize_single_triangle(const RasterTriangle& tri, color_t* buffer) {
-    int32_t x1 = tri.x1, y1 = tri.y1;
-    int32_t x2 = tri.x2, y2 = tri.y2;
-    int32_t x3 = tri.x3, y3 = tri.y3;
+// Lane value of one channel at a pixel inside the triangle (8-bit colour c3 at
+// vertex 3, d13 / d23 = c1 - c3 / c2 - c3), rounded down. n is area times the
+// 8-bit colour; the 8-bit colour is 4 lane units.
+static inline int32_t gouraud_lane(int32_t c3, int32_t d13, int32_t d23, int32_t edge1, int32_t edge2, int32_t area) {
+    int32_t n = c3 * area + edge1 * d13 + edge2 * d23;
+    return ((n / area) << 2) + ((n % area) << 2) / area;
+}
+
+// Packed colour at a pixel inside the triangle from its edge functions
+// (kept out of line: it only runs once per GOURAUD_RESEED_PIXELS)
+static __attribute__((noinline)) uint32_t gouraud_seed(const int32_t c3[3], const int32_t d13[3], const int32_t d23[3],
+                                                       int32_t edge1, int32_t edge2, int32_t area) {
+    return gouraud_pack(gouraud_lane(c3[0], d13[0], d23[0], edge1, edge2, area),
+                        gouraud_lane(c3[1], d13[1], d23[1], edge1, edge2, area),
+                        gouraud_lane(c3[2], d13[2], d23[2], edge1, edge2, area));
+}
+
+// color_t (ggggbbbbaaaarrrr) from the lanes' integer parts
+static inline color_t gouraud_color(uint32_t packed) {
+    return (color_t)(((packed >> 6) & 0x000F) | 0x00F0 | ((packed >> 8) & 0x0F00) | ((packed >> 14) & 0xF000));
+}
+
+// Texture coordinates (3 fractional bits) and 8-bit depth at a pixel from its
+// edge functions. q* are each vertex's 1/z relative to the nearest one
+// (1..1024) and uq* / vq* its coordinates times that, so it's all 32-bit.
+static inline void texture_point(int32_t edge1, int32_t edge2, int32_t area, int32_t z_near,
+                                 int32_t q1, int32_t q2, int32_t q3,
+                                 int32_t uq1, int32_t uq2, int32_t uq3,
+                                 int32_t vq1, int32_t vq2, int32_t vq3,
+                                 int32_t& u, int32_t& v, int32_t& z8) {
+    int32_t w1 = (FIXED_POINT_FACTOR * edge1) / area;
+    int32_t w2 = (FIXED_POINT_FACTOR * edge2) / area;
+    int32_t w3 = FIXED_POINT_FACTOR - (w1 + w2);
+    int32_t q = w1 * q1 + w2 * q2 + w3 * q3;
+    if (q <= 0) q = 1;
+    u = (int32_t)((uint32_t)(w1 * uq1 + w2 * uq2 + w3 * uq3) / (uint32_t)q);
+    v = (int32_t)((uint32_t)(w1 * vq1 + w2 * vq2 + w3 * vq3) / (uint32_t)q);
+    int32_t z = (z_near << 20) / q;
+    z8 = z * 255 / FIXED_POINT_FACTOR;
+    if (z8 > 255) z8 = 255;
+}
+
+// Texture-mapped triangle over its per-row spans, within the clipped bounding
+// box. Coordinates and depth are perspective-correct at the ends of each
+// RASTER_TEXTURE_SEGMENT-pixel segment and stepped linearly in between.
+static void rasterize_textured(const RasterTriangle& tri, const RasterTexCoords& coords, color_t* buffer,
+                               uint16_t* visibility, uint16_t index,
+                               int32_t viewport_width, int32_t x_small, int32_t x_large,
+                               int32_t y_small, int32_t y_large) {
+    int32_t x1 = raster_vertex_x(tri.v1), y1 = raster_vertex_y(tri.v1);
+    int32_t x2 = raster_vertex_x(tri.v2), y2 = raster_vertex_y(tri.v2);
+    int32_t x3 = raster_vertex_x(tri.v3), y3 = raster_vertex_y(tri.v3);
+    int32_t area = (x3 - x1) * (y2 - y1) - (y3 - y1) * (x2 - x1);
+
+    int32_t z1 = raster_vertex_z(tri.v1), z2 = raster_vertex_z(tri.v2), z3 = raster_vertex_z(tri.v3);
+    int32_t z_near = z1 < z2 ? z1 : z2;
+    if (z3 < z_near) z_near = z3;
+    int32_t q1 = (z_near << 10) / z1, q2 = (z_near << 10) / z2, q3 = (z_near << 10) / z3;
+    int32_t uq1 = coords.u1 * 8 * q1, uq2 = coords.u2 * 8 * q2, uq3 = coords.u3 * 8 * q3;
+    int32_t vq1 = coords.v1 * 8 * q1, vq2 = coords.v2 * 8 * q2, vq3 = coords.v3 * 8 * q3;
+
+    const RasterTexture& texture = textures[coords.texture];
+    const color_t* texels = texture.texels;
+    int32_t size_log2 = texture.size_log2;
+    int32_t mask = (1 << size_log2) - 1;
+
+    int32_t step1 = y3 - y2, step2 = y1 - y3, step3 = y2 - y1;
+
+    for (int32_t y = y_small; y <= y_large; y++) {
+        int32_t base1 = -x2 * step1 - (y - y2) * (x3 - x2);
+        int32_t base2 = -x3 * step2 - (y - y3) * (x1 - x3);
+        int32_t base3 = -x1 * step3 - (y - y1) * (x2 - x1);
+
+        int32_t x_start = x_small, x_end = x_large;
+        clip_span_to_edge(step1, base1, x_start, x_end);
+        clip_span_to_edge(step2, base2, x_start, x_end);
+        clip_span_to_edge(step3, base3, x_start, x_end);
+        if (x_start > x_end) continue;
+
+        int32_t u0, v0, d0;
+        texture_point(step1 * x_start + base1, step2 * x_start + base2, area, z_near,
+                      q1, q2, q3, uq1, uq2, uq3, vq1, vq2, vq3, u0, v0, d0);
+        color_t* row = buffer + y * viewport_width;
+        uint8_t* depth_row = depth_buffer_render + y * viewport_width;
+
+        // Each segment draws its first n pixels; the span's last pixel ends the row
+        int32_t x = x_start;
+        while (true) {
+            int32_t n = x_end - x;
+            if (n > RASTER_TEXTURE_SEGMENT) n = RASTER_TEXTURE_SEGMENT;
+            int32_t u1 = u0, v1 = v0, d1 = d0;
+            int32_t du = 0, dv = 0, dd = 0;
+            if (n > 0) {
+                int32_t xn = x + n;
+                texture_point(step1 * xn + base1, step2 * xn + base2, area, z_near,
+                              q1, q2, q3, uq1, uq2, uq3, vq1, vq2, vq3, u1, v1, d1);
+                du = ((u1 - u0) << 8) / n;
+                dv = ((v1 - v0) << 8) / n;
+                dd = ((d1 - d0) << 8) / n;
+            }
+
+            // 11 fractional bits: 3 from the coordinates, 8 for the steps
+            int32_t u = u0 << 8, v = v0 << 8, d = d0 << 8;
+            int32_t count = n > 0 ? n : 1;
+            for (int32_t i = 0; i < count; i++, x++, u += du, v += dv, d += dd) {
+                uint8_t z8 = (uint8_t)(d >> 8);
+                if (z8 > depth_row[x]) continue;
+                depth_row[x] = z8;
+                if (RASTER_VISIBILITY_BUFFER && visibility) {
+                    visibility[y * viewport_width + x] = index;
+                    raster_stats.fragments++;
+                    continue;
+                }
+                row[x] = texels[(((v >> 11) & mask) << size_log2) | ((u >> 11) & mask)];
+            }
+            if (n == 0) break;
+            u0 = u1; v0 = v1; d0 = d1;
+        }
+    }
+}
+
+// Per-triangle constants for shading its pixels (both backends)
+struct PixelShading {
+    const RasterTriangle* tri;
+    bool flat;
+    color_t flat_color;
+    int32_t r1, g1, b1, r2, g2, b2, r3, g3, b3;  // 8-bit vertex colours
+    int32_t zi1, zi2, zi3;                       // Inverse vertex depths
+    int32_t area;
+    int32_t c3[3], d13[3], d23[3];               // Packed Gouraud seed inputs (r, g, b)
+    uint32_t color_step;                         // Packed Gouraud step along a row
+    uint16_t* visibility;                        // Visibility buffer pass: index only
+    uint16_t index;
+};
+
+// 8-bit depth of a pixel from its barycentric weights (of FIXED_POINT_FACTOR);
+// false if it can't be drawn
+static inline bool pixel_depth(const PixelShading& s, int32_t w1, int32_t w2, uint8_t& z8) {
+    int32_t w3 = FIXED_POINT_FACTOR - (w1 + w2);
+    int32_t z_interp = w1 * s.zi1 + w2 * s.zi2 + w3 * s.zi3;
+    if (z_interp <= 0) return false;
+
+    int32_t z = (FIXED_POINT_FACTOR * FIXED_POINT_FACTOR * FIXED_POINT_FACTOR) / z_interp;
+    int32_t z_scaled = z * 255 / FIXED_POINT_FACTOR;
+    z8 = (uint8_t)(z_scaled > 255 ? 255 : (z_scaled < 0 ? 0 : z_scaled));
+    return true;
+}
+
+// Colour of a pixel that passed the depth test. color is the packed Gouraud
+// colour, stepped by the caller along the row and reseeded here from the
+// pixel's edge functions at color_seed_end.
+static inline void shade_pixel(const PixelShading& s, color_t* buffer, uint8_t* indices,
+                               int32_t x, int32_t y, int idx, int32_t w1, int32_t w2,
+                               int32_t edge1, int32_t edge2, uint32_t& color, int32_t& color_seed_end) {
+    const RasterTriangle& tri = *s.tri;
+    if (RASTER_VISIBILITY_BUFFER && s.visibility) {
+        s.visibility[idx] = s.index;
+        raster_stats.fragments++;
+        return;
+    }
+
+    if (indices) {
+        // Indexed path: pick a vertex colour by ordered dither on the weights
+        uint8_t c = tri.c1;
+        if (!s.flat) {
+            int32_t t = dither_thresholds[y & 3][x & 3];
+            c = (t < w1) ? tri.c1 : (t < w1 + w2) ? tri.c2 : tri.c3;
+        }
+        indices[idx] = c;
+        return;
+    }
+
+    if (s.flat) {
+        if (buffer) {
+            buffer[idx] = s.flat_color;
+        } else {
+            pen(s.r1 >> 4, s.g1 >> 4, s.b1 >> 4);
+            pixel(x, y);
+        }
+        return;
+    }
+
+    if (RASTER_SWAR_GOURAUD) {
+        // Packed Gouraud shading
+        if (x >= color_seed_end) {
+            color = gouraud_seed(s.c3, s.d13, s.d23, edge1, edge2, s.area);
+            color_seed_end = x + GOURAUD_RESEED_PIXELS;
+        }
+        color_t packed_color = gouraud_color(color);
+        if (buffer) {
+            buffer[idx] = packed_color;
+        } else {
+            pen(packed_color & 0xF, packed_color >> 12, (packed_color >> 8) & 0xF);
+            pixel(x, y);
+        }
+        return;
+    }
+
+    // Interpolate color (Gouraud shading)
+    int32_t w3 = FIXED_POINT_FACTOR - (w1 + w2);
+    int r = (int)((w1 * s.r1 + w2 * s.r2 + w3 * s.r3) / FIXED_POINT_FACTOR);
+    int g = (int)((w1 * s.g1 + w2 * s.g2 + w3 * s.g3) / FIXED_POINT_FACTOR);
+    int b = (int)((w1 * s.b1 + w2 * s.b2 + w3 * s.b3) / FIXED_POINT_FACTOR);
+
+    if (r < 0) r = 0;
+    if (r > 255) r = 255;
+    if (g < 0) g = 0;
+    if (g > 255) g = 255;
+    if (b < 0) b = 0;
+    if (b > 255) b = 255;
+
+    if (buffer) {
+        // Multicore path: write directly to provided framebuffer
+        buffer[idx] = rgb_to_color(r, g, b);
+    } else {
+        // Single-threaded path: use picosystem pen/pixel
+        pen(r >> 4, g >> 4, b >> 4);
+        pixel(x, y);
+    }
+}
+
+// floor(n / d) for d > 0, and the remainder in 0..d-1
+static inline int32_t floor_div(int32_t n, int32_t d, int32_t& r) {
+    int32_t q = n / d;
+    r = n - q * d;
+    if (r < 0) {
+        r += d;
+        q--;
+    }
+    return q;
+}
+
+// Exact integer walk of floor(n / d) (d > 0) while n steps by a constant:
+// quotient and remainder advance by the step's, with one carry check
+struct FloorWalk {
+    int32_t q, r;     // floor(n / d) and n - q * d
+    int32_t dq, dr;   // Same for the step
+    int32_t d;
+};
+
+static inline void floor_walk_init(FloorWalk& walk, int32_t step, int32_t d) {
+    walk.d = d;
+    walk.dq = floor_div(step, d, walk.dr);
+}
+
+static inline void floor_walk_start(FloorWalk& walk, int32_t n) {
+    walk.q = floor_div(n, walk.d, walk.r);
+}
+
+static inline void floor_walk_step(FloorWalk& walk) {
+    walk.q += walk.dq;
+    walk.r += walk.dr;
+    int32_t carry = walk.r >= walk.d;
+    walk.q += carry;
+    walk.r -= walk.d & -carry;
+}
+
+// Scanline backend: each edge's bound on x is walked down the rows exactly
+// (the same >= 0 rule as the edge functions, so the same pixels), and each
+// span's barycentric weights are walked along it, so a pixel costs one
+// divide (depth) instead of three and nothing outside the span is visited
+static void rasterize_scanline(const PixelShading& s, color_t* buffer, uint8_t* indices,
+                               int32_t viewport_width, int32_t x_small, int32_t x_large,
+                               int32_t y_small, int32_t y_large) {
+    const RasterTriangle& tri = *s.tri;
+    int32_t x1 = raster_vertex_x(tri.v1), y1 = raster_vertex_y(tri.v1);
+    int32_t x2 = raster_vertex_x(tri.v2), y2 = raster_vertex_y(tri.v2);
+    int32_t x3 = raster_vertex_x(tri.v3), y3 = raster_vertex_y(tri.v3);
+    int32_t area = s.area;
+
+    // Edge n is a_n * x + b_n, and b_n changes by c_n per row
+    int32_t a[3] = {y3 - y2, y1 - y3, y2 - y1};
+    int32_t c[3] = {-(x3 - x2), -(x1 - x3), -(x2 - x1)};
+    int32_t b[3] = {-x2 * a[0] - (y_small - y2) * (x3 - x2),
+                    -x3 * a[1] - (y_small - y3) * (x1 - x3),
+                    -x1 * a[2] - (y_small - y1) * (x2 - x1)};
+
+    // a > 0: x >= -floor(b / a) (a left edge); a < 0: x <= floor(b / -a)
+    // (a right edge); a == 0: the whole row if b >= 0
+    FloorWalk bound[3];
+    for (int e = 0; e < 3; e++) {
+        if (a[e] == 0) continue;
+        floor_walk_init(bound[e], c[e], a[e] > 0 ? a[e] : -a[e]);
+        floor_walk_start(bound[e], b[e]);
+    }
+
+    FloorWalk w1, w2;
+    floor_walk_init(w1, FIXED_POINT_FACTOR * a[0], area);
+    floor_walk_init(w2, FIXED_POINT_FACTOR * a[1], area);
+
+    for (int32_t y = y_small; y <= y_large; y++) {
+        int32_t x_start = x_small, x_end = x_large;
+        for (int e = 0; e < 3; e++) {
+            if (a[e] > 0) {
+                if (-bound[e].q > x_start) x_start = -bound[e].q;
+                floor_walk_step(bound[e]);
+            } else if (a[e] < 0) {
+                if (bound[e].q < x_end) x_end = bound[e].q;
+                floor_walk_step(bound[e]);
+            } else {
+                if (b[e] < 0) x_end = x_start - 1;
+                b[e] += c[e];
+            }
+        }
+        if (x_start > x_end) continue;
+
+        // Weights are floor(FIXED_POINT_FACTOR * edge / area), like the edge backend's
+        int32_t base1 = -x2 * a[0] - (y - y2) * (x3 - x2);
+        int32_t base2 = -x3 * a[1] - (y - y3) * (x1 - x3);
+        int32_t edge1 = a[0] * x_start + base1;
+        int32_t edge2 = a[1] * x_start + base2;
+        floor_walk_start(w1, FIXED_POINT_FACTOR * edge1);
+        floor_walk_start(w2, FIXED_POINT_FACTOR * edge2);
+
+        uint32_t color = 0;
+        int32_t color_seed_end = x_start;
+        int idx = y * viewport_width + x_start;
+
+        for (int32_t x = x_start; x <= x_end;
+             x++, idx++, floor_walk_step(w1), floor_walk_step(w2), color += s.color_step) {
+            uint8_t z8;
+            if (!pixel_depth(s, w1.q, w2.q, z8)) continue;
+            if (z8 > depth_buffer_render[idx]) continue;
+            depth_buffer_render[idx] = z8;
+
+            shade_pixel(s, buffer, indices, x, y, idx, w1.q, w2.q, a[0] * x + base1, a[1] * x + base2,
+                        color, color_seed_end);
+        }
+    }
+}
+
+// Rasterize a single triangle into a viewport_width x viewport_height target
+// Writes colours to buffer, palette indices to indices, or (both nullptr) uses pen/pixel;
+// with a visibility buffer, only depth and the triangle's index (colour is resolved later)
+// Returns the size class the triangle was drawn as
+static RasterClass rasterize_single_triangle(const RasterTriangle& tri, const RasterPalette& palette,
+                                             const RasterTexCoords* texcoords, color_t* buffer, uint8_t* indices,
+                                             uint16_t* visibility, uint16_t index,
+                                             int32_t viewport_width, int32_t viewport_height) {
+    int32_t x1 = raster_vertex_x(tri.v1), y1 = raster_vertex_y(tri.v1);
+    int32_t x2 = raster_vertex_x(tri.v2), y2 = raster_vertex_y(tri.v2);
+    int32_t x3 = raster_vertex_x(tri.v3), y3 = raster_vertex_y(tri.v3);
 
     // Calculate area for barycentric coordinates
     int32_t area = (x3 - x1) * (y2 - y1) - (y3 - y1) * (x2 - x1);
 
     // Backface culling
-    if (area <= 0) return;
+    if (area <= 0) return RASTER_CLASS_CULLED;
 
     // Bounding box
     int32_t x_large = x1, x_small = x1;
@@ -122,77 +837,293 @@ static void rasterize_single_triangle(const RasterTriangle& tri, color_t* buffer
     if (y2 < y_small) y_small = y2;
     if (y3 < y_small) y_small = y3;
 
-    // Clip to screen
-    if (x_large >= RASTER_SCREEN_WIDTH) x_large = RASTER_SCREEN_WIDTH - 1;
+    // Classify by the unclipped size, so a big triangle clipped to a corner isn't tiny
+    bool tiny = is_tiny(x_small, x_large, y_small, y_large);
+
+    // Clip to viewport
+    if (x_large >= viewport_width) x_large = viewport_width - 1;
     if (x_small < 0) x_small = 0;
-    if (y_large >= RASTER_SCREEN_HEIGHT) y_large = RASTER_SCREEN_HEIGHT - 1;
+    if (y_large >= viewport_height) y_large = viewport_height - 1;
     if (y_small < 0) y_small = 0;
 
-    if (x_large < x_small || y_large < y_small) return;
+    if (x_large < x_small || y_large < y_small) return RASTER_CLASS_CULLED;
+
+    // Z values (packing already clamped them to 1..FIXED_POINT_FACTOR)
+    int32_t z1 = raster_vertex_z(tri.v1);
+    int32_t z2 = raster_vertex_z(tri.v2);
+    int32_t z3 = raster_vertex_z(tri.v3);
+
+    // Vertex colours from the palette
+    uint32_t k1 = palette.keys[tri.c1], k2 = palette.keys[tri.c2], k3 = palette.keys[tri.c3];
+    int32_t r1 = (k1 >> 16) & 0xFF, g1 = (k1 >> 8) & 0xFF, b1 = k1 & 0xFF;
+    int32_t r2 = (k2 >> 16) & 0xFF, g2 = (k2 >> 8) & 0xFF, b2 = k2 & 0xFF;
+    int32_t r3 = (k3 >> 16) & 0xFF, g3 = (k3 >> 8) & 0xFF, b3 = k3 & 0xFF;
+    bool flat = (tri.flags & RASTER_FLAG_FLAT) != 0;
+    color_t flat_color = palette.colors[tri.c1];
 
-    // Z values
-    int32_t z1 = tri.z1; if (z1 < 1) z1 = 1; if (z1 > FIXED_POINT_FACTOR) z1 = FIXED_POINT_FACTOR;
-    int32_t z2 = tri.z2; if (z2 < 1) z2 = 1; if (z2 > FIXED_POINT_FACTOR) z2 = FIXED_POINT_FACTOR;
-    int32_t z3 = tri.z3; if (z3 < 1) z3 = 1; if (z3 > FIXED_POINT_FACTOR) z3 = FIXED_POINT_FACTOR;
+    if (tiny) {
+        // A few pixels at most: one depth (the vertex average) and one colour
+        // (the vertex average, or an even dither in indexed mode) for all of them
+        int32_t z_scaled = (z1 + z2 + z3) * 255 / (3 * FIXED_POINT_FACTOR);
+        uint8_t z8 = (uint8_t)(z_scaled > 255 ? 255 : z_scaled);
+        int32_t r = r1, g = g1, b = b1;
+        color_t color = flat_color;
+        if (!flat) {
+            r = (r1 + r2 + r3) / 3;
+            g = (g1 + g2 + g3) / 3;
+            b = (b1 + b2 + b3) / 3;
+            color = rgb_to_color(r, g, b);
+        }
+
+        for (int32_t y = y_small; y <= y_large; y++) {
+            for (int32_t x = x_small; x <= x_large; x++) {
+                if ((x - x2) * (y3 - y2) - (y - y2) * (x3 - x2) < 0) continue;
+                if ((x - x3) * (y1 - y3) - (y - y3) * (x1 - x3) < 0) continue;
+                if ((x - x1) * (y2 - y1) - (y - y1) * (x2 - x1) < 0) continue;
+
+                int idx = y * viewport_width + x;
+                if (z8 > depth_buffer_render[idx]) continue;
+                depth_buffer_render[idx] = z8;
+
+                if (RASTER_VISIBILITY_BUFFER && visibility) {
+                    visibility[idx] = index;
+                    raster_stats.fragments++;
+                } else if (indices) {
+                    uint8_t c = tri.c1;
+                    if (!flat) {
+                        int32_t t = dither_thresholds[y & 3][x & 3];
+                        c = (t < FIXED_POINT_FACTOR / 3) ? tri.c1 : (t < FIXED_POINT_FACTOR * 2 / 3) ? tri.c2 : tri.c3;
+                    }
+                    indices[idx] = c;
+                } else if (buffer) {
+                    buffer[idx] = color;
+                } else {
+                    pen(r >> 4, g >> 4, b >> 4);
+                    pixel(x, y);
+                }
+            }
+        }
+        return RASTER_CLASS_TINY;
+    }
+
+    // Textured triangles are only mapped into colour buffers; elsewhere they draw flat
+    if ((tri.flags & RASTER_FLAG_TEXTURED) && buffer) {
+        rasterize_textured(tri, texcoords[tri.c2], buffer, visibility, index,
+                           viewport_width, x_small, x_large, y_small, y_large);
+        return RASTER_CLASS_TEXTURED;
+    }
+
+    // Large triangles find each row's span from the edge equations instead of
+    // testing every pixel of the bounding box
+    bool spans = RASTER_SIZE_DISPATCH &&
+                 (x_large - x_small + 1) * (y_large - y_small + 1) >= RASTER_LARGE_PIXELS;
+    RasterClass cls = spans ? RASTER_CLASS_LARGE : RASTER_CLASS_MEDIUM;
+
+    // Edge functions step by these per pixel along a row
+    int32_t step1 = y3 - y2, step2 = y1 - y3, step3 = y2 - y1;
+
+    PixelShading shading;
+    shading.tri = &tri;
+    shading.flat = flat;
+    shading.flat_color = flat_color;
+    shading.r1 = r1; shading.g1 = g1; shading.b1 = b1;
+    shading.r2 = r2; shading.g2 = g2; shading.b2 = b2;
+    shading.r3 = r3; shading.g3 = g3; shading.b3 = b3;
 
     // Inverse Z for perspective-correct interpolation
-    int32_t zi1 = (FIXED_POINT_FACTOR * FIXED_POINT_FACTOR) / z1;
-    int32_t zi2 = (FIXED_POINT_FACTOR * FIXED_POINT_FACTOR) / z2;
-    int32_t zi3 = (FIXED_POINT_FACTOR * FIXED_POINT_FACTOR) / z3;
+    shading.zi1 = (FIXED_POINT_FACTOR * FIXED_POINT_FACTOR) / z1;
+    shading.zi2 = (FIXED_POINT_FACTOR * FIXED_POINT_FACTOR) / z2;
+    shading.zi3 = (FIXED_POINT_FACTOR * FIXED_POINT_FACTOR) / z3;
+
+    // Packed colour step along a row (each lane truncated toward zero)
+    shading.c3[0] = r3; shading.c3[1] = g3; shading.c3[2] = b3;
+    shading.d13[0] = r1 - r3; shading.d13[1] = g1 - g3; shading.d13[2] = b1 - b3;
+    shading.d23[0] = r2 - r3; shading.d23[1] = g2 - g3; shading.d23[2] = b2 - b3;
+    shading.area = area;
+    shading.visibility = visibility;
+    shading.index = index;
+    shading.color_step = 0;
+    if (RASTER_SWAR_GOURAUD && !flat && !indices && !visibility) {
+        shading.color_step = gouraud_pack(((step1 * shading.d13[0] + step2 * shading.d23[0]) << 2) / area,
+                                          ((step1 * shading.d13[1] + step2 * shading.d23[1]) << 2) / area,
+                                          ((step1 * shading.d13[2] + step2 * shading.d23[2]) << 2) / area);
+    }
+
+    if (raster_backend == RASTER_BACKEND_SCANLINE) {
+        rasterize_scanline(shading, buffer, indices, viewport_width, x_small, x_large, y_small, y_large);
+        return cls;
+    }
 
     // Rasterize
     for (int32_t y = y_small; y <= y_large; y++) {
         int8_t skipline = 0;
 
-        for (int32_t x = x_small; x <= x_large; x++) {
-            int32_t edge1 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
-            if (edge1 < 0) { if (skipline == 1) break; continue; }
+        // Edge n is step_n * x + base_n on this row
+        int32_t base1 = -x2 * step1 - (y - y2) * (x3 - x2);
+        int32_t base2 = -x3 * step2 - (y - y3) * (x1 - x3);
+        int32_t base3 = -x1 * step3 - (y - y1) * (x2 - x1);
 
-            int32_t edge2 = (x - x3) * (y1 - y3) - (y - y3) * (x1 - x3);
-            if (edge2 < 0) { if (skipline == 1) break; continue; }
+        int32_t x_start = x_small, x_end = x_large;
+        if (spans) {
+            clip_span_to_edge(step1, base1, x_start, x_end);
+            clip_span_to_edge(step2, base2, x_start, x_end);
+            clip_span_to_edge(step3, base3, x_start, x_end);
+        }
 
-            int32_t edge3 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
-            if (edge3 < 0) { if (skipline == 1) break; continue; }
+        int32_t edge1 = step1 * x_start + base1;
+        int32_t edge2 = step2 * x_start + base2;
+        int32_t edge3 = step3 * x_start + base3;
 
-            skipline = 1;
+        // Packed colour, seeded up to (not including) x = color_seed_end
+        uint32_t color = 0;
+        int32_t color_seed_end = x_start;
+
+        for (int32_t x = x_start; x <= x_end;
+             x++, edge1 += step1, edge2 += step2, edge3 += step3, color += shading.color_step) {
+            // Span pixels are inside by construction
+            if (!spans) {
+                if (edge1 < 0 || edge2 < 0 || edge3 < 0) { if (skipline == 1) break; continue; }
+                skipline = 1;
+            }
 
             // Barycentric weights
             int32_t w1 = (FIXED_POINT_FACTOR * edge1) / area;
             int32_t w2 = (FIXED_POINT_FACTOR * edge2) / area;
-            int32_t w3 = FIXED_POINT_FACTOR - (w1 + w2);
 
-            // Interpolate Z
-            int32_t z_interp = w1 * zi1 + w2 * zi2 + w3 * zi3;
-            if (z_interp <= 0) continue;
+            uint8_t z8;
+            if (!pixel_depth(shading, w1, w2, z8)) continue;
 
-            int32_t z = (FIXED_POINT_FACTOR * FIXED_POINT_FACTOR * FIXED_POINT_FACTOR) / z_interp;
+            int idx = y * viewport_width + x;
+            if (z8 > depth_buffer_render[idx]) continue;
+            depth_buffer_render[idx] = z8;
 
-            // Depth test (8-bit)
-            int32_t z_scaled = z * 255 / FIXED_POINT_FACTOR;
-            uint8_t z8 = (uint8_t)(z_scaled > 255 ? 255 : (z_scaled < 0 ? 0 : z_scaled));
+            shade_pixel(shading, buffer, indices, x, y, idx, w1, w2, edge1, edge2, color, color_seed_end);
+        }
+    }
+    return cls;
+}
 
-            int idx = y * RASTER_SCREEN_WIDTH + x;
+#if RASTER_VISIBILITY_BUFFER
+// How a triangle's visible pixels are resolved
+enum ResolveShading : uint8_t {
+    RESOLVE_FLAT,      // One colour (flat and tiny triangles)
+    RESOLVE_GOURAUD,
+    RESOLVE_TEXTURED,
+};
 
-            if (z8 > depth_buffer_render[idx]) continue;
-            depth_buffer_render[idx] = z8;
+// A triangle's constants for resolving its visible pixels
+struct ResolveTriangle {
+    ResolveShading shading;
+    color_t color;                               // RESOLVE_FLAT
+    int32_t x1, y1, x2, y2, x3, y3, area;
+    int32_t r1, g1, b1, r2, g2, b2, r3, g3, b3;  // RESOLVE_GOURAUD
+    const color_t* texels;                       // RESOLVE_TEXTURED (as in rasterize_textured)
+    int32_t size_log2, mask, z_near;
+    int32_t q1, q2, q3, uq1, uq2, uq3, vq1, vq2, vq3;
+};
 
-            // Interpolate color (Gouraud shading)
-            int r = (int)((w1 * tri.r1 + w2 * tri.r2 + w3 * tri.r3) / FIXED_POINT_FACTOR);
-            int g = (int)((w1 * tri.g1 + w2 * tri.g2 + w3 * tri.g3) / FIXED_POINT_FACTOR);
-            int b = (int)((w1 * tri.b1 + w2 * tri.b2 + w3 * tri.b3) / FIXED_POINT_FACTOR);
+static void resolve_setup(const RasterTriangle& tri, const RasterPalette& palette,
+                          const RasterTexCoords* texcoords, ResolveTriangle& rt) {
+    rt.x1 = raster_vertex_x(tri.v1); rt.y1 = raster_vertex_y(tri.v1);
+    rt.x2 = raster_vertex_x(tri.v2); rt.y2 = raster_vertex_y(tri.v2);
+    rt.x3 = raster_vertex_x(tri.v3); rt.y3 = raster_vertex_y(tri.v3);
+    rt.area = (rt.x3 - rt.x1) * (rt.y2 - rt.y1) - (rt.y3 - rt.y1) * (rt.x2 - rt.x1);
 
-            if (r < 0) r = 0; if (r > 255) r = 255;
-            if (g < 0) g = 0; if (g > 255) g = 255;
-            if (b < 0) b = 0; if (b > 255) b = 255;
+    // c2 / c3 are only palette indices on Gouraud triangles (a textured
+    // triangle's c2 indexes its texture coordinates, and it's always flat)
+    bool flat = (tri.flags & RASTER_FLAG_FLAT) != 0;
+    if (!flat) {
+        uint32_t k1 = palette.keys[tri.c1], k2 = palette.keys[tri.c2], k3 = palette.keys[tri.c3];
+        rt.r1 = (k1 >> 16) & 0xFF; rt.g1 = (k1 >> 8) & 0xFF; rt.b1 = k1 & 0xFF;
+        rt.r2 = (k2 >> 16) & 0xFF; rt.g2 = (k2 >> 8) & 0xFF; rt.b2 = k2 & 0xFF;
+        rt.r3 = (k3 >> 16) & 0xFF; rt.g3 = (k3 >> 8) & 0xFF; rt.b3 = k3 & 0xFF;
+    }
 
-            if (buffer) {
-                // Multicore path: write directly to provided framebuffer
-                buffer[idx] = rgb_to_color(r, g, b);
-            } else {
-                // Single-threaded path: use picosystem pen/pixel
-                pen(r >> 4, g >> 4, b >> 4);
-                pixel(x, y);
+    // Same choices as rasterize_single_triangle made in the first pass
+    int32_t x_small = rt.x1 < rt.x2 ? rt.x1 : rt.x2, x_large = rt.x1 > rt.x2 ? rt.x1 : rt.x2;
+    int32_t y_small = rt.y1 < rt.y2 ? rt.y1 : rt.y2, y_large = rt.y1 > rt.y2 ? rt.y1 : rt.y2;
+    if (rt.x3 < x_small) x_small = rt.x3;
+    if (rt.x3 > x_large) x_large = rt.x3;
+    if (rt.y3 < y_small) y_small = rt.y3;
+    if (rt.y3 > y_large) y_large = rt.y3;
+
+    rt.shading = RESOLVE_FLAT;
+    rt.color = palette.colors[tri.c1];
+    if (is_tiny(x_small, x_large, y_small, y_large)) {
+        if (!flat) rt.color = rgb_to_color((rt.r1 + rt.r2 + rt.r3) / 3, (rt.g1 + rt.g2 + rt.g3) / 3,
+                                           (rt.b1 + rt.b2 + rt.b3) / 3);
+    } else if (tri.flags & RASTER_FLAG_TEXTURED) {
+        const RasterTexCoords& coords = texcoords[tri.c2];
+        const RasterTexture& texture = textures[coords.texture];
+        int32_t z1 = raster_vertex_z(tri.v1), z2 = raster_vertex_z(tri.v2), z3 = raster_vertex_z(tri.v3);
+        rt.shading = RESOLVE_TEXTURED;
+        rt.texels = texture.texels;
+        rt.size_log2 = texture.size_log2;
+        rt.mask = (1 << texture.size_log2) - 1;
+        rt.z_near = z1 < z2 ? z1 : z2;
+        if (z3 < rt.z_near) rt.z_near = z3;
+        rt.q1 = (rt.z_near << 10) / z1; rt.q2 = (rt.z_near << 10) / z2; rt.q3 = (rt.z_near << 10) / z3;
+        rt.uq1 = coords.u1 * 8 * rt.q1; rt.uq2 = coords.u2 * 8 * rt.q2; rt.uq3 = coords.u3 * 8 * rt.q3;
+        rt.vq1 = coords.v1 * 8 * rt.q1; rt.vq2 = coords.v2 * 8 * rt.q2; rt.vq3 = coords.v3 * 8 * rt.q3;
+    } else if (!flat) {
+        rt.shading = RESOLVE_GOURAUD;
+    }
+}
+
+static inline color_t resolve_pixel(const ResolveTriangle& rt, int32_t x, int32_t y) {
+    if (rt.shading == RESOLVE_FLAT) return rt.color;
+
+    int32_t edge1 = (x - rt.x2) * (rt.y3 - rt.y2) - (y - rt.y2) * (rt.x3 - rt.x2);
+    int32_t edge2 = (x - rt.x3) * (rt.y1 - rt.y3) - (y - rt.y3) * (rt.x1 - rt.x3);
+    if (rt.shading == RESOLVE_TEXTURED) {
+        int32_t u, v, z8;
+        texture_point(edge1, edge2, rt.area, rt.z_near, rt.q1, rt.q2, rt.q3,
+                      rt.uq1, rt.uq2, rt.uq3, rt.vq1, rt.vq2, rt.vq3, u, v, z8);
+        return rt.texels[(((v >> 3) & rt.mask) << rt.size_log2) | ((u >> 3) & rt.mask)];
+    }
+
+    int32_t w1 = (FIXED_POINT_FACTOR * edge1) / rt.area;
+    int32_t w2 = (FIXED_POINT_FACTOR * edge2) / rt.area;
+    int32_t w3 = FIXED_POINT_FACTOR - (w1 + w2);
+    int r = (int)((w1 * rt.r1 + w2 * rt.r2 + w3 * rt.r3) / FIXED_POINT_FACTOR);
+    int g = (int)((w1 * rt.g1 + w2 * rt.g2 + w3 * rt.g3) / FIXED_POINT_FACTOR);
+    int b = (int)((w1 * rt.b1 + w2 * rt.b2 + w3 * rt.b3) / FIXED_POINT_FACTOR);
+
+    if (r < 0) r = 0;
+    if (r > 255) r = 255;
+    if (g < 0) g = 0;
+    if (g > 255) g = 255;
+    if (b < 0) b = 0;
+    if (b > 255) b = 255;
+    return rgb_to_color(r, g, b);
+}
+
+// Second pass: shade each viewport pixel once from the triangle that won its
+// depth test, or the sky. Neighbouring pixels mostly share a triangle, so its
+// setup is kept until the index changes.
+static void resolve_visibility(color_t* buffer, int32_t viewport_width, int32_t viewport_height) {
+    const RasterPalette& palette = *palette_current;
+    ResolveTriangle rt = {};
+    uint16_t cached = VISIBILITY_NONE;
+    uint32_t covered = 0;
+    for (int32_t y = 0; y < viewport_height; y++) {
+        color_t sky = sky_color(y * RASTER_SCREEN_HEIGHT / viewport_height);
+        const uint16_t* visibility = visibility_buffer + y * viewport_width;
+        color_t* row = buffer + y * viewport_width;
+        for (int32_t x = 0; x < viewport_width; x++) {
+            uint16_t index = visibility[x];
+            if (index == VISIBILITY_NONE) {
+                row[x] = sky;
+                continue;
+            }
+            if (index != cached) {
+                resolve_setup(triangle_list_current[index], palette, texcoord_list_current, rt);
+                cached = index;
             }
+            row[x] = resolve_pixel(rt, x, y);
+            covered++;
         }
     }
+    raster_stats.covered = covered;
 }
+#endif
@@ -5,25 +5,166 @@
 
 using namespace picosystem;
 
-// Maximum triangles per frame (matches Pico3D)
-#define MAX_TRIANGLES 1500
+// Maximum triangles per frame (packed triangles freed room for more than Pico3D's 1500)
+#define MAX_TRIANGLES 2048
+
+// Per-frame colour palette size (triangles store 8-bit indices into it)
+// Index 0 is reserved for the sky background
+#define RASTER_PALETTE_SIZE 256
+
+// Indexed colour mode: Core 1 rasterizes 8-bit palette indices instead of
+// color_t, and the frame is expanded to color_t in one pass at the swap.
+// Replaces the second 28.8KB colour framebuffer with a 14.4KB index buffer.
+// Gouraud triangles are ordered-dithered between their vertex colours.
+#ifndef RASTER_INDEXED_COLOR
+#define RASTER_INDEXED_COLOR 0
+#endif
+
+// Size-adaptive dispatch: tiny triangles take a single depth sample and
+// colour, large ones walk per-row spans instead of testing edges over their
+// whole bounding box. 0 sends everything through the bounding-box scan.
+#ifndef RASTER_SIZE_DISPATCH
+#define RASTER_SIZE_DISPATCH 1
+#endif
+
+// Packed Gouraud colour: r, g and b are stepped together in one 32-bit word
+// (one add per pixel) and shifted straight into color_t. Within one 4-bit
+// level per channel of the per-channel interpolation. 0 interpolates each
+// channel separately.
+#ifndef RASTER_SWAR_GOURAUD
+#define RASTER_SWAR_GOURAUD 1
+#endif
+
+// Visibility buffer: Core 1 first rasterizes only depth and a 16-bit triangle
+// index per pixel, then shades each pixel once from its winning triangle, so
+// shading costs one pass over the viewport however much overdraw there is.
+// Costs a 28.8KB index buffer. Colour-buffer path only (the indexed mode
+// already writes one byte per fragment). Gouraud pixels are interpolated per
+// channel, as with RASTER_SWAR_GOURAUD 0.
+#ifndef RASTER_VISIBILITY_BUFFER
+#define RASTER_VISIBILITY_BUFFER 0
+#endif
+
+// Frame skip: rasterizer_swap_lists hashes the list it swaps in (triangles,
+// texture coordinates, palette and viewport, so the camera too, through the
+// projected vertices) and rasterizer_list_unchanged() reports a match with
+// the list before it, whose frame can then be reused instead of rendered
+#ifndef RASTER_FRAME_SKIP
+#define RASTER_FRAME_SKIP 1
+#endif
+
+// Rasterization backend for medium and large triangles at startup (see
+// RasterBackend); rasterizer_set_backend switches it at runtime
+#ifndef RASTER_DEFAULT_BACKEND
+#define RASTER_DEFAULT_BACKEND RASTER_BACKEND_EDGE
+#endif
+
+// Triangles whose unclipped bounding box is at most this many pixels on each side are tiny
+#define RASTER_TINY_SIZE 3
+
+// Triangles whose clipped bounding box covers at least this many pixels are large
+#define RASTER_LARGE_PIXELS 1024
+
+// Sky gradient at a full-screen row (the background, and the fog colour)
+inline void rasterizer_sky_rgb(int y, uint8_t& r, uint8_t& g, uint8_t& b) {
+    r = (uint8_t)(40 + y / 6);
+    g = (uint8_t)(60 + y / 4);
+    b = (uint8_t)(120 + y / 3);
+}
 
 // Screen dimensions (must match render3d.hpp)
+// These are the maximum raster dimensions; the per-frame viewport may be smaller
 #define RASTER_SCREEN_WIDTH 120
 #define RASTER_SCREEN_HEIGHT 120
 
-// Compact triangle structure for rasterization (28 bytes)
+// Packed triangle structure for rasterization (16 bytes)
+// Each vertex word holds x:10 | y:10 | z-1:10 (x/y signed, z in 1..1024)
+// Colours are indices into the per-frame palette of the list the triangle is in
 struct RasterTriangle {
-    int16_t x1, y1;           // Vertex 1 screen coords
-    int16_t x2, y2;           // Vertex 2 screen coords
-    int16_t x3, y3;           // Vertex 3 screen coords
-    uint16_t z1, z2, z3;      // Depth values (in FIXED_POINT range)
-    uint8_t r1, g1, b1;       // Vertex 1 color
-    uint8_t r2, g2, b2;       // Vertex 2 color
-    uint8_t r3, g3, b3;       // Vertex 3 color
-    uint8_t pad;              // Padding for alignment
+    uint32_t v1, v2, v3;      // Packed vertex words
+    uint8_t c1, c2, c3;       // Vertex palette indices
+    uint8_t flags;            // RASTER_FLAG_*
+};
+
+// All three vertices share one colour (no Gouraud interpolation needed)
+#define RASTER_FLAG_FLAT 0x01
+
+// Texture-mapped: c2 indexes the list's texture coordinates instead of the
+// palette, and c1 is the flat colour used where the triangle isn't textured
+// (tiny triangles, indexed colour mode and the pen/pixel path)
+#define RASTER_FLAG_TEXTURED 0x02
+
+// Textured triangles per frame (more are submitted flat)
+#define MAX_TEXTURED_TRIANGLES 256
+
+// Texture slots (see rasterizer_set_texture)
+#define RASTER_MAX_TEXTURES 32
+
+// Textured spans are perspective-corrected every this many pixels and
+// interpolated linearly in between
+#define RASTER_TEXTURE_SEGMENT 8
+
+// Texture coordinates of a textured triangle, in texels (wrapping at the texture size)
+struct RasterTexCoords {
+    uint8_t u1, v1, u2, v2, u3, v3;
+    uint8_t texture;   // Texture slot
+    uint8_t _pad;
+};
+
+// Packed screen coordinate range (10-bit signed: 4x guard band around the screen)
+#define RASTER_COORD_MIN -512
+#define RASTER_COORD_MAX 511
+
+// Pack a screen-space vertex. Returns false if x/y fall outside the packed range.
+inline bool raster_pack_vertex(int32_t x, int32_t y, int32_t z, uint32_t& out) {
+    if (x < RASTER_COORD_MIN || x > RASTER_COORD_MAX) return false;
+    if (y < RASTER_COORD_MIN || y > RASTER_COORD_MAX) return false;
+    if (z < 1) z = 1;
+    if (z > 1024) z = 1024;
+    out = ((uint32_t)x & 0x3FF) | (((uint32_t)y & 0x3FF) << 10) | ((uint32_t)(z - 1) << 20);
+    return true;
+}
+
+inline int32_t raster_vertex_x(uint32_t v) { return ((int32_t)(v << 22)) >> 22; }
+inline int32_t raster_vertex_y(uint32_t v) { return ((int32_t)(v << 12)) >> 22; }
+inline int32_t raster_vertex_z(uint32_t v) { return (int32_t)((v >> 20) & 0x3FF) + 1; }
+
+// Size classes triangles are dispatched by
+enum RasterClass : uint8_t {
+    RASTER_CLASS_CULLED,   // Back-facing, degenerate or outside the viewport
+    RASTER_CLASS_TINY,     // One depth sample and one colour
+    RASTER_CLASS_MEDIUM,   // Edge tests over the bounding box (scanline backend: spans)
+    RASTER_CLASS_LARGE,    // Per-row spans from the edge equations
+    RASTER_CLASS_TEXTURED, // Per-row spans, texture mapped
+    RASTER_CLASS_COUNT,
 };
 
+// Backends for the medium and large triangles (tiny and textured ones have their own paths)
+// Both fill exactly the pixels with all edge functions >= 0, at the same depth and colour
+enum RasterBackend : uint8_t {
+    RASTER_BACKEND_EDGE,      // Edge functions over the bounding box (spans for large triangles)
+    RASTER_BACKEND_SCANLINE,  // Left / right edges walked per row, weights stepped along spans
+    RASTER_BACKEND_COUNT,
+};
+
+// Triangle counts and rasterization time per class for the last rendered list
+// With the visibility buffer, fragments (pixels that passed the depth test,
+// each one a shade without it) over the pixels covered is the overdraw, and
+// time_us is the first pass only
+struct RasterStats {
+    uint32_t triangles[RASTER_CLASS_COUNT];
+    uint32_t time_us[RASTER_CLASS_COUNT];
+    uint32_t fragments;   // Visibility buffer only
+    uint32_t covered;     // Visibility buffer only: pixels shaded by the resolve
+    uint32_t resolve_us;  // Visibility buffer only
+};
+
+// Overdraw of the last rendered list in tenths (10 = every covered pixel
+// written once; 0 without the visibility buffer)
+inline uint32_t rasterizer_overdraw_tenths(const RasterStats& stats) {
+    return stats.covered ? (stats.fragments * 10 + stats.covered / 2) / stats.covered : 0;
+}
+
 // Initialize the rasterizer (call once at startup)
 void rasterizer_init();
 
@@ -31,6 +172,18 @@ void rasterizer_init();
 // Returns false if the list is full
 bool rasterizer_submit_triangle(const RasterTriangle& tri);
 
+// Submit a textured triangle; tri.c1 is its fallback colour (c2, c3 and flags are set here)
+// Returns false if the list is full; once the texture coordinates run out it's submitted flat
+bool rasterizer_submit_textured_triangle(RasterTriangle tri, const RasterTexCoords& coords);
+
+// Point a texture slot at size x size colours, row-major (size = 1 << size_log2)
+// The texels must stay valid while triangles using the slot can be rendered
+void rasterizer_set_texture(uint8_t slot, const color_t* texels, uint8_t size_log2);
+
+// Look up (or add) a colour in the palette of the frame being built
+// Falls back to the nearest existing colour once the palette is full
+uint8_t rasterizer_palette_index(uint8_t r, uint8_t g, uint8_t b);
+
 // Get current triangle count in the frame being built
 uint32_t rasterizer_get_triangle_count();
 
@@ -44,13 +197,40 @@ uint32_t rasterizer_end_frame();
 // Check if rasterizer is busy (always false in single-threaded mode)
 bool rasterizer_is_busy();
 
+// Set the raster viewport for the frame being built (clamped to RASTER_SCREEN_*)
+// Triangles submitted this frame must be projected into this viewport
+void rasterizer_set_viewport(int32_t width, int32_t height);
+
 // === Multicore API (called from game.cpp) ===
 
 // Render triangles directly to a framebuffer (called by Core 1)
 // count: number of triangles to render from the "current" list
 // buffer: pointer to the framebuffer (color_t array)
+// A viewport smaller than RASTER_SCREEN_* is rendered packed at the start of
+// the buffer and then upscaled (colour and depth) to the full screen
 void rasterizer_render_to_buffer(uint32_t count, color_t* buffer);
 
-// Swap the "current" and "next" triangle lists
+#if RASTER_INDEXED_COLOR
+// Render triangles into the internal palette-index buffer (called by Core 1)
+void rasterizer_render_indexed(uint32_t count);
+
+// Expand the last indexed frame to color_t, upscaling the viewport to the full
+// screen (called by Core 0 after Core 1 finishes, before swapping lists)
+void rasterizer_expand_to_buffer(color_t* buffer);
+#endif
+
+// Stats of the last rasterizer_render_to_buffer / rasterizer_render_indexed
+// (written by Core 1, so read them after it has finished)
+const RasterStats& rasterizer_get_stats();
+
+// Select the backend used by the next render (set it while Core 1 is idle)
+void rasterizer_set_backend(RasterBackend backend);
+RasterBackend rasterizer_get_backend();
+
+// Swap the "current" and "next" triangle lists (and their viewports)
 // Called after Core 1 finishes rendering
 void rasterizer_swap_lists();
+
+// True if the list the last rasterizer_swap_lists made current is identical
+// to the one current before it (always false without RASTER_FRAME_SKIP)
+bool rasterizer_list_unchanged();
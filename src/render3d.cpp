@@ -8,6 +8,7 @@
 #define CAMERA_FOVX 180.0f
 #define CAMERA_FOVY 180.0f
 #define PI 3.14159265f
+static_assert(RENDER3D_FIXED_ONE == FIXED_POINT_FACTOR, "fixed-point entry points use the projection's units");
 
 uint8_t depth_buffer_a[DEPTH_WIDTH * DEPTH_HEIGHT];
 uint8_t depth_buffer_b[DEPTH_WIDTH * DEPTH_HEIGHT];
@@ -21,8 +22,21 @@ static float mat_camera[4][4];
 static float mat_projection[4][4];
 static int32_t mat_vp[4][4];
 
+// Horizontal view wedge for render3d_visible_xz: apex and the two side plane
+// normals (XZ), updated with the camera
+static float view_apex[2];
+static float view_plane[2][2];
+
+// Raster viewport for the frame being built (billboards always use the full screen)
+static int32_t viewport_width = SCREEN_WIDTH;
+static int32_t viewport_height = SCREEN_HEIGHT;
+
 static inline int32_t float_to_fixed(float in) { return (int32_t)(in * FIXED_POINT_FACTOR); }
 
+// Fog start view depth (fixed point) and fog levels per fixed-point unit << 16
+static int32_t fog_start = INT32_MAX;
+static int32_t fog_scale = 0;
+
 static void mat_mul(float mat1[4][4], float mat2[4][4], float out[4][4]) {
     for (int y = 0; y < 4; y++) for (int x = 0; x < 4; x++) {
         out[y][x] = 0;
@@ -48,6 +62,12 @@ void render3d_init() {
 }
 
 void render3d_begin_frame() { rasterizer_begin_frame(); }
+
+void render3d_set_viewport(int width, int height) {
+    rasterizer_set_viewport(width, height);
+    viewport_width = std::min(std::max(width, 1), SCREEN_WIDTH);
+    viewport_height = std::min(std::max(height, 1), SCREEN_HEIGHT);
+}
 uint32_t render3d_end_frame() { return 0; }
 void render3d_clear() {
     memset(depth_buffer_a, 0xFF, sizeof(depth_buffer_a));
@@ -85,65 +105,303 @@ static void render_view_projection() {
 
 void render3d_third_person_camera(float px, float py, float pz, float pyaw) {
     float cam_dist = 8.0f, cam_height = 4.0f;
-    camera_position[0] = px - sinf(pyaw) * cam_dist;
+    // The player moves along -(sin yaw, cos yaw), so the camera sits behind
+    // them on +(sin yaw, cos yaw). The view looks down the camera's -z axis,
+    // hence the negated look-at direction.
+    camera_position[0] = px + sinf(pyaw) * cam_dist;
     camera_position[1] = py + cam_height;
-    camera_position[2] = pz - cosf(pyaw) * cam_dist;
+    camera_position[2] = pz + cosf(pyaw) * cam_dist;
     float dx = px - camera_position[0], dy = (py + 1.0f) - camera_position[1], dz = pz - camera_position[2];
-    camera_yaw = atan2f(dx, dz);
+    camera_yaw = atan2f(-dx, -dz);
     camera_pitch = atan2f(dy, sqrtf(dx*dx + dz*dz));
+
+    // The horizontal FOV is ~45 degrees each side. Pitching down widens what's
+    // visible below the camera, so the wedge apex sits a little behind it.
+    float fwd_x = -sinf(camera_yaw), fwd_z = -cosf(camera_yaw);
+    const float half_sin = 0.731f, half_cos = 0.682f;  // 47 degrees
+    view_apex[0] = camera_position[0] - fwd_x * 2.0f;
+    view_apex[1] = camera_position[2] - fwd_z * 2.0f;
+    view_plane[0][0] = fwd_x * half_sin + fwd_z * half_cos;
+    view_plane[0][1] = fwd_z * half_sin - fwd_x * half_cos;
+    view_plane[1][0] = fwd_x * half_sin - fwd_z * half_cos;
+    view_plane[1][1] = fwd_z * half_sin + fwd_x * half_cos;
     update_camera();
     render_view_projection();
 }
 
-static bool project_vertex(float wx, float wy, float wz, int32_t& sx, int32_t& sy, int32_t& sz) {
-    int32_t fx = float_to_fixed(wx), fy = float_to_fixed(wy), fz = float_to_fixed(wz);
+bool render3d_visible_xz(float min_x, float min_z, float max_x, float max_z, float max_distance) {
+    // Nearest point of the box to the camera
+    float nx = std::min(std::max(camera_position[0], min_x), max_x) - camera_position[0];
+    float nz = std::min(std::max(camera_position[2], min_z), max_z) - camera_position[2];
+    if (nx*nx + nz*nz > max_distance*max_distance) return false;
+
+    // Outside if every corner is behind one side plane
+    for (int p = 0; p < 2; p++) {
+        float px = view_plane[p][0], pz = view_plane[p][1];
+        float ax = view_apex[0], az = view_apex[1];
+        if ((min_x-ax)*px + (min_z-az)*pz < 0 && (max_x-ax)*px + (min_z-az)*pz < 0 &&
+            (min_x-ax)*px + (max_z-az)*pz < 0 && (max_x-ax)*px + (max_z-az)*pz < 0) return false;
+    }
+    return true;
+}
+
+void render3d_set_fog(float start, float end) {
+    if (end <= start) {
+        fog_start = INT32_MAX;
+        fog_scale = 0;
+        return;
+    }
+    fog_start = float_to_fixed(start);
+    fog_scale = (int32_t)((RENDER3D_FOG_LEVELS << 16) / (float_to_fixed(end) - fog_start));
+}
+
+// Fog level at a fixed-point view depth
+static inline uint8_t fog_level(int32_t w) {
+    if (w <= fog_start) return 0;
+    int32_t level = (int32_t)(((int64_t)(w - fog_start) * fog_scale) >> 16);
+    return (uint8_t)std::min(level, (int32_t)RENDER3D_FOG_LEVELS);
+}
+
+// fog receives the vertex's fog level (w is the view depth, in fixed point)
+static bool project_vertex_fixed(int32_t fx, int32_t fy, int32_t fz, int32_t vw, int32_t vh,
+                                 int32_t& sx, int32_t& sy, int32_t& sz, uint8_t& fog) {
     int32_t w = ((mat_vp[3][0]*fx) + (mat_vp[3][1]*fy) + (mat_vp[3][2]*fz) + (mat_vp[3][3]*FIXED_POINT_FACTOR)) / FIXED_POINT_FACTOR;
     if (w <= 0) return false;
+    fog = fog_level(w);
     int32_t cx = ((mat_vp[0][0]*fx) + (mat_vp[0][1]*fy) + (mat_vp[0][2]*fz) + (mat_vp[0][3]*FIXED_POINT_FACTOR)) / w;
     int32_t cy = ((mat_vp[1][0]*fx) + (mat_vp[1][1]*fy) + (mat_vp[1][2]*fz) + (mat_vp[1][3]*FIXED_POINT_FACTOR)) / w;
     int32_t cz = ((mat_vp[2][0]*fx) + (mat_vp[2][1]*fy) + (mat_vp[2][2]*fz) + (mat_vp[2][3]*FIXED_POINT_FACTOR)) / w;
     if (cz <= 0 || cz > FIXED_POINT_FACTOR) return false;
-    sx = (cx + FIXED_POINT_FACTOR) * (SCREEN_WIDTH - 1) / FIXED_POINT_FACTOR / 2;
-    sy = SCREEN_HEIGHT - ((cy + FIXED_POINT_FACTOR) * (SCREEN_HEIGHT - 1)) / FIXED_POINT_FACTOR / 2;
+    sx = (cx + FIXED_POINT_FACTOR) * (vw - 1) / FIXED_POINT_FACTOR / 2;
+    sy = vh - ((cy + FIXED_POINT_FACTOR) * (vh - 1)) / FIXED_POINT_FACTOR / 2;
     sz = cz;
     return true;
 }
 
-void render3d_triangle(const VertexScreen& v0, const VertexScreen& v1, const VertexScreen& v2) {
+static bool project_vertex(float wx, float wy, float wz, int32_t vw, int32_t vh,
+                           int32_t& sx, int32_t& sy, int32_t& sz, uint8_t& fog) {
+    return project_vertex_fixed(float_to_fixed(wx), float_to_fixed(wy), float_to_fixed(wz), vw, vh, sx, sy, sz, fog);
+}
+
+bool render3d_project_fx(int32_t x, int32_t y, int32_t z, VertexScreen& out) {
+    int32_t sx, sy, sz;
+    if (!project_vertex_fixed(x, y, z, viewport_width, viewport_height, sx, sy, sz, out.fog)) return false;
+    out.x = sx; out.y = sy; out.z = sz;
+    return true;
+}
+
+// Fog blends toward the sky at the third-person camera's horizon row, where
+// distant geometry meets the sky. One colour rather than the sky behind each
+// vertex keeps every base colour to RENDER3D_FOG_LEVELS fogged variants, and
+// snapping them to the middle of the display's 4-bit steps merges the ones
+// that would look the same, so fog rarely overflows the palette.
+#define FOG_SKY_ROW 39
+
+void render3d_fog_rgb(uint8_t level, uint8_t& r, uint8_t& g, uint8_t& b) {
+    if (level == 0) return;
+    uint8_t sky_r, sky_g, sky_b;
+    rasterizer_sky_rgb(FOG_SKY_ROW, sky_r, sky_g, sky_b);
+    r = (uint8_t)(((r + ((int32_t)sky_r - r) * level / RENDER3D_FOG_LEVELS) & 0xF0) | 0x08);
+    g = (uint8_t)(((g + ((int32_t)sky_g - g) * level / RENDER3D_FOG_LEVELS) & 0xF0) | 0x08);
+    b = (uint8_t)(((b + ((int32_t)sky_b - b) * level / RENDER3D_FOG_LEVELS) & 0xF0) | 0x08);
+}
+
+static inline void apply_fog(VertexScreen& v) {
+    if (v.fog != 0) render3d_fog_rgb(v.fog, v.r, v.g, v.b);
+}
+
+static inline bool fully_fogged(const VertexScreen& v0, const VertexScreen& v1, const VertexScreen& v2) {
+    return v0.fog == RENDER3D_FOG_LEVELS && v1.fog == RENDER3D_FOG_LEVELS && v2.fog == RENDER3D_FOG_LEVELS;
+}
+
+static inline bool in_guard_band(const VertexScreen& v) {
+    return v.x >= RASTER_COORD_MIN && v.x <= RASTER_COORD_MAX && v.y >= RASTER_COORD_MIN && v.y <= RASTER_COORD_MAX;
+}
+
+// Up to one more vertex per clip edge
+#define CLIP_MAX_VERTICES 7
+
+// Point where the edge from a (inside) to b crosses x = bound (axis 0) or
+// y = bound (axis 1). Colours are screen-linear like the Gouraud shading,
+// while depth and texels go by 1 / z like the rasterizer's perspective.
+static VertexScreen clip_point(const VertexScreen& a, const VertexScreen& b, int axis, int32_t bound) {
+    float ta = axis ? a.y : a.x, tb = axis ? b.y : b.x;
+    float t = (bound - ta) / (tb - ta);
+    float zia = 1.0f / a.z, zib = 1.0f / b.z;
+    float zi = zia + (zib - zia) * t;
+    VertexScreen p;
+    p.x = axis ? (int16_t)lroundf(a.x + (b.x - a.x) * t) : (int16_t)bound;
+    p.y = axis ? (int16_t)bound : (int16_t)lroundf(a.y + (b.y - a.y) * t);
+    p.z = (uint16_t)std::min(std::max(lroundf(1.0f / zi), 1L), (long)FIXED_POINT_FACTOR);
+    p.r = (uint8_t)lroundf(a.r + (b.r - a.r) * t);
+    p.g = (uint8_t)lroundf(a.g + (b.g - a.g) * t);
+    p.b = (uint8_t)lroundf(a.b + (b.b - a.b) * t);
+    p.u = (uint8_t)lroundf((a.u * zia + (b.u * zib - a.u * zia) * t) / zi);
+    p.v = (uint8_t)lroundf((a.v * zia + (b.v * zib - a.v * zia) * t) / zi);
+    p.fog = a.fog;
+    return p;
+}
+
+// Clip a triangle to the packed coordinate range (Sutherland-Hodgman), so
+// geometry right in front of the camera is drawn rather than dropped.
+// Returns the vertex count of the convex polygon left in poly.
+static int clip_to_guard_band(const VertexScreen& v0, const VertexScreen& v1, const VertexScreen& v2,
+                              VertexScreen poly[CLIP_MAX_VERTICES]) {
+    VertexScreen buffer[CLIP_MAX_VERTICES];
+    VertexScreen* in = poly;
+    VertexScreen* out = buffer;
+    in[0] = v0; in[1] = v1; in[2] = v2;
+    int count = 3;
+    for (int edge = 0; edge < 4 && count > 0; edge++) {
+        int axis = edge >> 1;
+        int32_t bound = (edge & 1) ? RASTER_COORD_MAX : RASTER_COORD_MIN;
+        int32_t sign = (edge & 1) ? -1 : 1;
+        int out_count = 0;
+        for (int i = 0; i < count; i++) {
+            const VertexScreen& a = in[i];
+            const VertexScreen& b = in[(i + 1) % count];
+            bool a_in = ((axis ? a.y : a.x) - bound) * sign >= 0;
+            bool b_in = ((axis ? b.y : b.x) - bound) * sign >= 0;
+            if (a_in) out[out_count++] = a;
+            // Always clip from the inside end, so edges shared by two triangles split identically
+            if (a_in && !b_in) out[out_count++] = clip_point(a, b, axis, bound);
+            else if (!a_in && b_in) out[out_count++] = clip_point(b, a, axis, bound);
+        }
+        std::swap(in, out);
+        count = out_count;
+    }
+    if (in != poly) std::copy(in, in + count, poly);
+    return count;
+}
+
+static void submit_packed(const VertexScreen& v0, const VertexScreen& v1, const VertexScreen& v2) {
     RasterTriangle tri;
-    tri.x1 = v0.x; tri.y1 = v0.y; tri.x2 = v1.x; tri.y2 = v1.y; tri.x3 = v2.x; tri.y3 = v2.y;
-    tri.z1 = v0.z; tri.z2 = v1.z; tri.z3 = v2.z;
-    tri.r1 = v0.r; tri.g1 = v0.g; tri.b1 = v0.b;
-    tri.r2 = v1.r; tri.g2 = v1.g; tri.b2 = v1.b;
-    tri.r3 = v2.r; tri.g3 = v2.g; tri.b3 = v2.b;
-    tri.pad = 0;
+    raster_pack_vertex(v0.x, v0.y, v0.z, tri.v1);
+    raster_pack_vertex(v1.x, v1.y, v1.z, tri.v2);
+    raster_pack_vertex(v2.x, v2.y, v2.z, tri.v3);
+    tri.c1 = rasterizer_palette_index(v0.r, v0.g, v0.b);
+    tri.c2 = rasterizer_palette_index(v1.r, v1.g, v1.b);
+    tri.c3 = rasterizer_palette_index(v2.r, v2.g, v2.b);
+    tri.flags = (tri.c1 == tri.c2 && tri.c2 == tri.c3) ? RASTER_FLAG_FLAT : 0;
     rasterizer_submit_triangle(tri);
 }
 
+// c1: palette index of the colour used where the triangle can't be textured
+static void submit_textured_packed(const VertexScreen& v0, const VertexScreen& v1, const VertexScreen& v2,
+                                   uint8_t texture, uint8_t c1) {
+    RasterTriangle tri;
+    raster_pack_vertex(v0.x, v0.y, v0.z, tri.v1);
+    raster_pack_vertex(v1.x, v1.y, v1.z, tri.v2);
+    raster_pack_vertex(v2.x, v2.y, v2.z, tri.v3);
+    tri.c1 = c1;
+    RasterTexCoords coords = {v0.u, v0.v, v1.u, v1.v, v2.u, v2.v, texture, 0};
+    rasterizer_submit_textured_triangle(tri, coords);
+}
+
+static void submit_triangle(const VertexScreen& v0, const VertexScreen& v1, const VertexScreen& v2) {
+    if (in_guard_band(v0) && in_guard_band(v1) && in_guard_band(v2)) {
+        submit_packed(v0, v1, v2);
+        return;
+    }
+    VertexScreen poly[CLIP_MAX_VERTICES];
+    int count = clip_to_guard_band(v0, v1, v2, poly);
+    for (int i = 1; i + 1 < count; i++) submit_packed(poly[0], poly[i], poly[i + 1]);
+}
+
+void render3d_triangle(const VertexScreen& v0, const VertexScreen& v1, const VertexScreen& v2) {
+    if ((v0.fog | v1.fog | v2.fog) == 0) {
+        submit_triangle(v0, v1, v2);
+        return;
+    }
+    if (fully_fogged(v0, v1, v2)) return;
+    VertexScreen f0 = v0, f1 = v1, f2 = v2;
+    apply_fog(f0); apply_fog(f1); apply_fog(f2);
+    submit_triangle(f0, f1, f2);
+}
+
+void render3d_textured_triangle(const VertexScreen& v0, const VertexScreen& v1, const VertexScreen& v2,
+                                uint8_t texture) {
+    // The face takes the fogged copy of its texture for its mean fog level
+    uint8_t level = (uint8_t)((v0.fog + v1.fog + v2.fog + 1) / 3);
+    if (level > 0) {
+        if (fully_fogged(v0, v1, v2)) return;
+        level = std::min(level, (uint8_t)(RENDER3D_FOG_LEVELS - 1));
+        texture = (uint8_t)(texture + level * RENDER3D_FOG_TEXTURE_STRIDE);
+    }
+    // Where it can't be textured, the face is v0's colour fogged like the texture
+    uint8_t r = v0.r, g = v0.g, b = v0.b;
+    render3d_fog_rgb(level, r, g, b);
+    uint8_t c1 = rasterizer_palette_index(r, g, b);
+    if (in_guard_band(v0) && in_guard_band(v1) && in_guard_band(v2)) {
+        submit_textured_packed(v0, v1, v2, texture, c1);
+        return;
+    }
+    VertexScreen poly[CLIP_MAX_VERTICES];
+    int count = clip_to_guard_band(v0, v1, v2, poly);
+    for (int i = 1; i + 1 < count; i++) submit_textured_packed(poly[0], poly[i], poly[i + 1], texture, c1);
+}
+
 static const float cube_verts[8][3] = {
     {-0.5f, 0.0f, -0.5f}, {0.5f, 0.0f, -0.5f}, {0.5f, 1.0f, -0.5f}, {-0.5f, 1.0f, -0.5f},
     {-0.5f, 0.0f,  0.5f}, {0.5f, 0.0f,  0.5f}, {0.5f, 1.0f,  0.5f}, {-0.5f, 1.0f,  0.5f}
 };
 static const uint8_t cube_faces[6][4] = {{0,3,2,1},{5,6,7,4},{4,7,3,0},{1,2,6,5},{3,7,6,2},{4,0,1,5}};
 
-void render3d_cube(float px, float py, float pz, float szx, float szy, float szz,
-                   uint8_t r_top, uint8_t g_top, uint8_t b_top, uint8_t r_side, uint8_t g_side, uint8_t b_side) {
-    VertexScreen sv[8]; bool visible[8];
+static void project_box(float px, float py, float pz, float szx, float szy, float szz,
+                        VertexScreen sv[8], bool visible[8]) {
     for (int i = 0; i < 8; i++) {
         float wx = px + cube_verts[i][0]*szx, wy = py + cube_verts[i][1]*szy, wz = pz + cube_verts[i][2]*szz;
         int32_t scx, scy, scz;
-        visible[i] = project_vertex(wx, wy, wz, scx, scy, scz);
+        visible[i] = project_vertex(wx, wy, wz, viewport_width, viewport_height, scx, scy, scz, sv[i].fog);
+        if (visible[i]) { sv[i].x = scx; sv[i].y = scy; sv[i].z = scz; }
+    }
+}
+
+// Fixed-point box: x / z centred on (px, pz), y from py up
+static void project_box_fixed(int32_t px, int32_t py, int32_t pz, int32_t szx, int32_t szy, int32_t szz,
+                              VertexScreen sv[8], bool visible[8]) {
+    int32_t x0 = px - szx / 2, x1 = x0 + szx;
+    int32_t z0 = pz - szz / 2, z1 = z0 + szz;
+    for (int i = 0; i < 8; i++) {
+        int32_t fx = cube_verts[i][0] < 0 ? x0 : x1;
+        int32_t fy = cube_verts[i][1] > 0 ? py + szy : py;
+        int32_t fz = cube_verts[i][2] < 0 ? z0 : z1;
+        int32_t scx, scy, scz;
+        visible[i] = project_vertex_fixed(fx, fy, fz, viewport_width, viewport_height, scx, scy, scz, sv[i].fog);
         if (visible[i]) { sv[i].x = scx; sv[i].y = scy; sv[i].z = scz; }
     }
+}
+
+// Texels across a fixed-point wall length (wrapping is fine, the coordinates are 8-bit)
+static inline uint8_t wall_texels(int32_t length) {
+    int32_t texels = length * RENDER3D_TEXELS_PER_UNIT / FIXED_POINT_FACTOR;
+    return (uint8_t)(texels > 255 ? 255 : texels);
+}
+
+// wall_texture: first of the side faces' pre-shaded texture slots, mapped over
+// wall_x / wall_z texels across the x / z faces and wall_y up them
+static void submit_box(VertexScreen sv[8], const bool visible[8],
+                       uint8_t r_top, uint8_t g_top, uint8_t b_top, uint8_t r_side, uint8_t g_side, uint8_t b_side,
+                       int wall_texture = RENDER3D_NO_TEXTURE,
+                       uint8_t wall_x = 0, uint8_t wall_y = 0, uint8_t wall_z = 0) {
     for (int face = 0; face < 6; face++) {
         const uint8_t* f = cube_faces[face];
         if (!visible[f[0]] || !visible[f[1]] || !visible[f[2]] || !visible[f[3]]) continue;
         uint8_t r, g, b;
         if (face == 4) { r = r_top; g = g_top; b = b_top; }
         else if (face == 5) { r = r_side/2; g = g_side/2; b = b_side/2; }
-        else { float sh = (face==0)?0.7f:(face==1)?0.9f:(face==2)?0.6f:1.0f; r=(uint8_t)(r_side*sh); g=(uint8_t)(g_side*sh); b=(uint8_t)(b_side*sh); }
+        else { float sh = RENDER3D_SIDE_SHADE[face]; r=(uint8_t)(r_side*sh); g=(uint8_t)(g_side*sh); b=(uint8_t)(b_side*sh); }
         VertexScreen v0=sv[f[0]], v1=sv[f[1]], v2=sv[f[2]], v3=sv[f[3]];
         v0.r=r; v0.g=g; v0.b=b; v1.r=r; v1.g=g; v1.b=b; v2.r=r; v2.g=g; v2.b=b; v3.r=r; v3.g=g; v3.b=b;
+        if (face < 4 && wall_texture != RENDER3D_NO_TEXTURE) {
+            // Side faces run bottom-left, top-left, top-right, bottom-right
+            uint8_t width = face < 2 ? wall_x : wall_z;
+            v0.u = 0; v0.v = wall_y; v1.u = 0; v1.v = 0;
+            v2.u = width; v2.v = 0; v3.u = width; v3.v = wall_y;
+            uint8_t texture = (uint8_t)(wall_texture + face);
+            render3d_textured_triangle(v0, v1, v2, texture); render3d_textured_triangle(v0, v2, v3, texture);
+            continue;
+        }
         if (face != 4 && face != 5) {
             v1.r=std::min(255,r+30); v1.g=std::min(255,g+30); v1.b=std::min(255,b+30);
             v2.r=std::min(255,r+30); v2.g=std::min(255,g+30); v2.b=std::min(255,b+30);
@@ -152,9 +410,201 @@ void render3d_cube(float px, float py, float pz, float szx, float szy, float szz
     }
 }
 
+void render3d_cube(float px, float py, float pz, float szx, float szy, float szz,
+                   uint8_t r_top, uint8_t g_top, uint8_t b_top, uint8_t r_side, uint8_t g_side, uint8_t b_side) {
+    VertexScreen sv[8]; bool visible[8];
+    project_box(px, py, pz, szx, szy, szz, sv, visible);
+    submit_box(sv, visible, r_top, g_top, b_top, r_side, g_side, b_side);
+}
+
+// Occlusion map (see render3d.hpp); 0xFFFF = nothing in front
+static uint16_t occlusion_map[OCCLUSION_MAP_SIZE * OCCLUSION_MAP_SIZE];
+static bool occlusion_empty = true;
+int render3d_occluded_count = 0;
+
+// Interpolated depths can round a little past the vertex range, and the depth
+// buffer keeps 8 bits, so an occludee must be this much deeper (in projected z)
+static const int32_t OCCLUSION_DEPTH_MARGIN = 8;
+
+// First pixel of occlusion cell i along an axis of `size` pixels
+// (pixel x is in cell x * OCCLUSION_MAP_SIZE / size)
+static inline int32_t occlusion_cell_start(int32_t i, int32_t size) {
+    return (i * size + OCCLUSION_MAP_SIZE - 1) / OCCLUSION_MAP_SIZE;
+}
+
+// Same edge function (and >= 0 inside rule) as the rasterizer
+static inline int32_t occlusion_edge(const VertexScreen& a, const VertexScreen& b, int32_t x, int32_t y) {
+    return (x - a.x) * (b.y - a.y) - (y - a.y) * (b.x - a.x);
+}
+
+void render3d_occlusion_begin() {
+    for (int i = 0; i < OCCLUSION_MAP_SIZE * OCCLUSION_MAP_SIZE; i++) occlusion_map[i] = 0xFFFF;
+    occlusion_empty = true;
+    render3d_occluded_count = 0;
+}
+
+static void occluder_projected_box(const VertexScreen sv[8], const bool visible[8]) {
+    for (int face = 0; face < 6; face++) {
+        const uint8_t* f = cube_faces[face];
+        const VertexScreen* q[4];
+        bool drawn = true;
+        int32_t min_x = INT32_MAX, min_y = INT32_MAX, max_x = INT32_MIN, max_y = INT32_MIN, max_z = 0;
+        for (int k = 0; k < 4; k++) {
+            const VertexScreen& v = sv[f[k]];
+            q[k] = &v;
+            // Only faces that render3d_triangle will actually submit can hide anything
+            if (!visible[f[k]] || v.x < RASTER_COORD_MIN || v.x > RASTER_COORD_MAX ||
+                v.y < RASTER_COORD_MIN || v.y > RASTER_COORD_MAX) { drawn = false; break; }
+            min_x = std::min(min_x, (int32_t)v.x); max_x = std::max(max_x, (int32_t)v.x);
+            min_y = std::min(min_y, (int32_t)v.y); max_y = std::max(max_y, (int32_t)v.y);
+            max_z = std::max(max_z, (int32_t)v.z);
+        }
+        if (!drawn) continue;
+
+        // Front-facing (not backface culled) and convex, so the quad is exactly
+        // the union of its two triangles
+        bool convex = true;
+        for (int k = 0; k < 4 && convex; k++) {
+            if (occlusion_edge(*q[k], *q[(k + 1) & 3], q[(k + 2) & 3]->x, q[(k + 2) & 3]->y) <= 0) convex = false;
+        }
+        if (!convex) continue;
+
+        // Cells whose corner pixels are all inside the quad are fully covered
+        min_x = std::max(min_x, (int32_t)0); max_x = std::min(max_x, viewport_width - 1);
+        min_y = std::max(min_y, (int32_t)0); max_y = std::min(max_y, viewport_height - 1);
+        if (min_x > max_x || min_y > max_y) continue;
+        int32_t cell_x0 = min_x * OCCLUSION_MAP_SIZE / viewport_width;
+        int32_t cell_x1 = max_x * OCCLUSION_MAP_SIZE / viewport_width;
+        int32_t cell_y0 = min_y * OCCLUSION_MAP_SIZE / viewport_height;
+        int32_t cell_y1 = max_y * OCCLUSION_MAP_SIZE / viewport_height;
+        for (int cy = cell_y0; cy <= cell_y1; cy++) {
+            int32_t y0 = occlusion_cell_start(cy, viewport_height);
+            int32_t y1 = occlusion_cell_start(cy + 1, viewport_height) - 1;
+            if (y0 < min_y || y1 > max_y || y1 < y0) continue;
+            for (int cx = cell_x0; cx <= cell_x1; cx++) {
+                int32_t x0 = occlusion_cell_start(cx, viewport_width);
+                int32_t x1 = occlusion_cell_start(cx + 1, viewport_width) - 1;
+                if (x0 < min_x || x1 > max_x || x1 < x0) continue;
+
+                bool inside = true;
+                for (int k = 0; k < 4 && inside; k++) {
+                    const VertexScreen& a = *q[k];
+                    const VertexScreen& b = *q[(k + 1) & 3];
+                    inside = occlusion_edge(a, b, x0, y0) >= 0 && occlusion_edge(a, b, x1, y0) >= 0 &&
+                             occlusion_edge(a, b, x0, y1) >= 0 && occlusion_edge(a, b, x1, y1) >= 0;
+                }
+                if (!inside) continue;
+
+                uint16_t& cell = occlusion_map[cy * OCCLUSION_MAP_SIZE + cx];
+                if (max_z < cell) cell = (uint16_t)max_z;
+                occlusion_empty = false;
+            }
+        }
+    }
+}
+
+void render3d_occluder_box(float px, float py, float pz, float szx, float szy, float szz) {
+    VertexScreen sv[8]; bool visible[8];
+    project_box(px, py, pz, szx, szy, szz, sv, visible);
+    occluder_projected_box(sv, visible);
+}
+
+void render3d_occluder_box_fx(int32_t px, int32_t py, int32_t pz, int32_t szx, int32_t szy, int32_t szz) {
+    VertexScreen sv[8]; bool visible[8];
+    project_box_fixed(px, py, pz, szx, szy, szz, sv, visible);
+    occluder_projected_box(sv, visible);
+}
+
+// True if every cell under the projected box has an occluder in front of all of it
+static bool projected_box_occluded(const VertexScreen sv[8], const bool visible[8]) {
+    if (occlusion_empty) return false;
+
+    int32_t min_x = INT32_MAX, min_y = INT32_MAX, max_x = INT32_MIN, max_y = INT32_MIN, min_z = INT32_MAX;
+    for (int i = 0; i < 8; i++) {
+        if (!visible[i]) return false;
+        min_x = std::min(min_x, (int32_t)sv[i].x); max_x = std::max(max_x, (int32_t)sv[i].x);
+        min_y = std::min(min_y, (int32_t)sv[i].y); max_y = std::max(max_y, (int32_t)sv[i].y);
+        min_z = std::min(min_z, (int32_t)sv[i].z);
+    }
+    min_x = std::max(min_x, (int32_t)0); max_x = std::min(max_x, viewport_width - 1);
+    min_y = std::max(min_y, (int32_t)0); max_y = std::min(max_y, viewport_height - 1);
+    if (min_x > max_x || min_y > max_y) return false;
+
+    int32_t cell_x0 = min_x * OCCLUSION_MAP_SIZE / viewport_width;
+    int32_t cell_x1 = max_x * OCCLUSION_MAP_SIZE / viewport_width;
+    int32_t cell_y0 = min_y * OCCLUSION_MAP_SIZE / viewport_height;
+    int32_t cell_y1 = max_y * OCCLUSION_MAP_SIZE / viewport_height;
+    for (int32_t cy = cell_y0; cy <= cell_y1; cy++) {
+        for (int32_t cx = cell_x0; cx <= cell_x1; cx++) {
+            if (occlusion_map[cy * OCCLUSION_MAP_SIZE + cx] + OCCLUSION_DEPTH_MARGIN >= min_z) return false;
+        }
+    }
+    return true;
+}
+
+bool render3d_box_occluded(float px, float py, float pz, float szx, float szy, float szz) {
+    VertexScreen sv[8]; bool visible[8];
+    project_box(px, py, pz, szx, szy, szz, sv, visible);
+    if (!projected_box_occluded(sv, visible)) return false;
+    render3d_occluded_count++;
+    return true;
+}
+
+bool render3d_cube_if_visible(float px, float py, float pz, float szx, float szy, float szz,
+                              uint8_t r_top, uint8_t g_top, uint8_t b_top,
+                              uint8_t r_side, uint8_t g_side, uint8_t b_side) {
+    VertexScreen sv[8]; bool visible[8];
+    project_box(px, py, pz, szx, szy, szz, sv, visible);
+    if (projected_box_occluded(sv, visible)) {
+        render3d_occluded_count++;
+        return false;
+    }
+    submit_box(sv, visible, r_top, g_top, b_top, r_side, g_side, b_side);
+    return true;
+}
+
+void render3d_cube_fx(int32_t px, int32_t py, int32_t pz, int32_t szx, int32_t szy, int32_t szz,
+                      uint8_t r_top, uint8_t g_top, uint8_t b_top,
+                      uint8_t r_side, uint8_t g_side, uint8_t b_side, int wall_texture) {
+    VertexScreen sv[8]; bool visible[8];
+    project_box_fixed(px, py, pz, szx, szy, szz, sv, visible);
+    submit_box(sv, visible, r_top, g_top, b_top, r_side, g_side, b_side,
+               wall_texture, wall_texels(szx), wall_texels(szy), wall_texels(szz));
+}
+
+bool render3d_cube_if_visible_fx(int32_t px, int32_t py, int32_t pz, int32_t szx, int32_t szy, int32_t szz,
+                                 uint8_t r_top, uint8_t g_top, uint8_t b_top,
+                                 uint8_t r_side, uint8_t g_side, uint8_t b_side, int wall_texture) {
+    VertexScreen sv[8]; bool visible[8];
+    project_box_fixed(px, py, pz, szx, szy, szz, sv, visible);
+    if (projected_box_occluded(sv, visible)) {
+        render3d_occluded_count++;
+        return false;
+    }
+    submit_box(sv, visible, r_top, g_top, b_top, r_side, g_side, b_side,
+               wall_texture, wall_texels(szx), wall_texels(szy), wall_texels(szz));
+    return true;
+}
+
+void render3d_camera_xz(float& x, float& z) {
+    x = camera_position[0];
+    z = camera_position[2];
+}
+
+void render3d_view_wedge(float& apex_x, float& apex_z, float normals[2][2]) {
+    apex_x = view_apex[0];
+    apex_z = view_apex[1];
+    for (int p = 0; p < 2; p++) {
+        normals[p][0] = view_plane[p][0];
+        normals[p][1] = view_plane[p][1];
+    }
+}
+
 void render3d_billboard(float wx, float wy, float wz, BillboardDrawFunc draw_func, float base_size, color_t* fb) {
     int32_t sx, sy, sz;
-    if (!project_vertex(wx, wy, wz, sx, sy, sz)) return;
+    uint8_t fog;
+    if (!project_vertex(wx, wy, wz, SCREEN_WIDTH, SCREEN_HEIGHT, sx, sy, sz, fog)) return;
+    if (fog == RENDER3D_FOG_LEVELS) return;
     if (sx < -50 || sx >= SCREEN_WIDTH+50 || sy < -50 || sy >= SCREEN_HEIGHT+50) return;
     float dx = wx - camera_position[0], dy = wy - camera_position[1], dz = wz - camera_position[2];
     float dist = sqrtf(dx*dx + dy*dy + dz*dz);
@@ -17,9 +17,14 @@ struct VertexScreen {
     int16_t x, y;
     uint16_t z;
     uint8_t r, g, b;
-    uint8_t _pad;
+    uint8_t u, v;    // Texels (render3d_textured_triangle only)
+    uint8_t fog;     // 0 (clear) .. RENDER3D_FOG_LEVELS (sky), set by the projection
 };
 
+// Fog steps between clear and fully fogged; few steps keep the palette small
+// and neighbouring vertices at the same step share one colour
+constexpr int RENDER3D_FOG_LEVELS = 8;
+
 // Double-buffered depth buffers (8-bit each = 14.4KB x 2)
 // Core 1 writes to one while Core 0 reads from the other
 extern uint8_t depth_buffer_a[DEPTH_WIDTH * DEPTH_HEIGHT];
@@ -32,6 +37,10 @@ void render3d_init();
 
 // Begin/end frame
 void render3d_begin_frame();
+
+// Set the internal raster resolution for the frame being built
+// (geometry is projected into width x height and upscaled to the screen)
+void render3d_set_viewport(int width, int height);
 uint32_t render3d_end_frame();
 
 // Clear depth buffer
@@ -40,14 +49,90 @@ void render3d_clear();
 // Set camera position
 void render3d_third_person_camera(float player_x, float player_y, float player_z, float player_yaw);
 
+// Distance fog: vertex colours blend toward the sky at the horizon from start
+// to end view depth, and anything fully fogged (at end or beyond) is dropped.
+// end <= start turns fog off.
+void render3d_set_fog(float start, float end);
+
+// Blend a colour toward the fog colour by a fog level (0 .. RENDER3D_FOG_LEVELS)
+void render3d_fog_rgb(uint8_t level, uint8_t& r, uint8_t& g, uint8_t& b);
+
+// Conservative test of a world-space XZ box against the camera's horizontal
+// view wedge and a maximum distance (false = certainly not visible)
+bool render3d_visible_xz(float min_x, float min_z, float max_x, float max_z, float max_distance);
+
 // Render a triangle
 void render3d_triangle(const VertexScreen& v0, const VertexScreen& v1, const VertexScreen& v2);
 
+// Render a texture-mapped triangle; the vertex colour of v0 is used where it
+// can't be textured (too small, or indexed colour mode). A fogged triangle
+// uses the copy of the texture fogged by its mean level (render3d_fog_rgb),
+// in slot texture + level * RENDER3D_FOG_TEXTURE_STRIDE.
+void render3d_textured_triangle(const VertexScreen& v0, const VertexScreen& v1, const VertexScreen& v2,
+                                uint8_t texture);
+
+// Side faces of a cube are shaded by direction (-z, +z, -x, +x). A wall
+// texture needs a copy pre-shaded by each, in slots texture + 0..3, and
+// fogged copies of those for fog levels 1 .. RENDER3D_FOG_LEVELS - 1.
+constexpr float RENDER3D_SIDE_SHADE[4] = {0.7f, 0.9f, 0.6f, 1.0f};
+constexpr int RENDER3D_FOG_TEXTURE_STRIDE = 4;
+constexpr int RENDER3D_NO_TEXTURE = -1;
+constexpr int32_t RENDER3D_TEXELS_PER_UNIT = 8;  // Wall texture density
+
+// Project a fixed-point world position (RENDER3D_FIXED_ONE units) into the
+// viewport; false if it's behind the camera or beyond the depth range
+bool render3d_project_fx(int32_t x, int32_t y, int32_t z, VertexScreen& out);
+
 // Render a cube
 void render3d_cube(float px, float py, float pz, float sx, float sy, float sz,
                    uint8_t r_top, uint8_t g_top, uint8_t b_top,
                    uint8_t r_side, uint8_t g_side, uint8_t b_side);
 
+// World units for the *_fx entry points (same fixed point as the projection)
+constexpr int32_t RENDER3D_FIXED_ONE = 1024;
+
+// render3d_cube with fixed-point position and size, and optionally textured side faces
+void render3d_cube_fx(int32_t px, int32_t py, int32_t pz, int32_t sx, int32_t sy, int32_t sz,
+                      uint8_t r_top, uint8_t g_top, uint8_t b_top,
+                      uint8_t r_side, uint8_t g_side, uint8_t b_side,
+                      int wall_texture = RENDER3D_NO_TEXTURE);
+
+// Coarse occlusion map over the viewport, rebuilt each frame. Each cell holds
+// the farthest depth of an occluder face that fully covers it, so a box that
+// is deeper than every cell under its screen bounds is certainly hidden.
+constexpr int OCCLUSION_MAP_SIZE = 30;
+
+// Objects rejected by the occlusion tests since render3d_occlusion_begin()
+extern int render3d_occluded_count;
+
+// Clear the occlusion map (after the camera and viewport are set)
+void render3d_occlusion_begin();
+
+// Add a box's front faces to the occlusion map (the box must also be drawn)
+void render3d_occluder_box(float px, float py, float pz, float sx, float sy, float sz);
+
+void render3d_occluder_box_fx(int32_t px, int32_t py, int32_t pz, int32_t sx, int32_t sy, int32_t sz);
+
+// True if a box (same placement as render3d_cube) is hidden by the occluders
+bool render3d_box_occluded(float px, float py, float pz, float sx, float sy, float sz);
+
+// render3d_cube unless the box is occluded; returns false if nothing was submitted
+bool render3d_cube_if_visible(float px, float py, float pz, float sx, float sy, float sz,
+                              uint8_t r_top, uint8_t g_top, uint8_t b_top,
+                              uint8_t r_side, uint8_t g_side, uint8_t b_side);
+
+bool render3d_cube_if_visible_fx(int32_t px, int32_t py, int32_t pz, int32_t sx, int32_t sy, int32_t sz,
+                                 uint8_t r_top, uint8_t g_top, uint8_t b_top,
+                                 uint8_t r_side, uint8_t g_side, uint8_t b_side,
+                                 int wall_texture = RENDER3D_NO_TEXTURE);
+
+// Camera position on the ground plane
+void render3d_camera_xz(float& x, float& z);
+
+// Horizontal view wedge used by render3d_visible_xz: a point is in view if
+// (p - apex) . normal >= 0 for both side plane normals
+void render3d_view_wedge(float& apex_x, float& apex_z, float normals[2][2]);
+
 // Render a billboard
 // draw_func receives: x, y, scale, depth, and a framebuffer pointer (nullptr = use pen/pixel)
 typedef void (*BillboardDrawFunc)(int x, int y, float scale, uint8_t depth, color_t* fb);
@@ -68,6 +153,6 @@ inline bool depth_test(int x, int y, uint8_t z) {
 void render3d_swap_depth_buffers();
 
 // RGB to 4-bit color (picosystem format: ggggbbbbaaaarrrr)
-inline color_t rgb_to_color(uint8_t r, uint8_t g, uint8_t b) {
+constexpr color_t rgb_to_color(uint8_t r, uint8_t g, uint8_t b) {
     return (r >> 4) | (0xF << 4) | ((b >> 4) << 8) | ((g >> 4) << 12);
 }
@@ -0,0 +1,29 @@
+#include "resolution.hpp"
+
+void resolution_update(ResolutionState& state, uint32_t raster_us, uint32_t target_us, bool adapt) {
+    int32_t diff = (int32_t)raster_us - (int32_t)state.time_avg_us;
+    state.time_avg_us = (uint32_t)((int32_t)state.time_avg_us + diff / 8);
+    uint32_t abs_diff = (uint32_t)(diff < 0 ? -diff : diff);
+    state.time_dev_us = state.time_dev_us + abs_diff / 8 - state.time_dev_us / 8;
+    if (!adapt) return;
+
+    // Wait for the last change to show up in the measurements
+    if (state.cooldown > 0) {
+        state.cooldown--;
+        return;
+    }
+
+    if (state.time_avg_us > target_us * 9 / 10 && state.step < NUM_RESOLUTION_STEPS - 1) {
+        state.step++;
+        state.cooldown = RESOLUTION_COOLDOWN_FRAMES;
+    } else if (state.step > 0) {
+        // Only step up if the larger viewport (scaled by pixel count) still fits
+        uint32_t cur = RESOLUTION_STEPS[state.step];
+        uint32_t up = RESOLUTION_STEPS[state.step - 1];
+        uint32_t predicted = state.time_avg_us * (up * up) / (cur * cur);
+        if (predicted < target_us * 3 / 4) {
+            state.step--;
+            state.cooldown = RESOLUTION_COOLDOWN_FRAMES;
+        }
+    }
+}
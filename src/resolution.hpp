@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+
+// Dynamic resolution: the rasterizer runs at a lower internal resolution when
+// it can't keep up, and the result is upscaled to the full 120x120 frame.
+// The controller smooths the raster time and steps between the sizes with
+// hysteresis, waiting a cooldown after each change for it to show up.
+
+constexpr int RESOLUTION_STEPS[] = {120, 96, 80};  // Viewport side per step
+constexpr int NUM_RESOLUTION_STEPS = sizeof(RESOLUTION_STEPS) / sizeof(RESOLUTION_STEPS[0]);
+constexpr int RESOLUTION_COOLDOWN_FRAMES = 30;
+
+struct ResolutionState {
+    int step;              // Index into RESOLUTION_STEPS
+    int cooldown;          // Frames before the next change
+    uint32_t time_avg_us;  // Smoothed raster time (EMA, 1/8)
+    uint32_t time_dev_us;  // Smoothed absolute deviation (frame-time jitter)
+};
+
+// Feed the raster time of a rendered frame; with adapt, picks the step for
+// the next frame against target_us (without, only the averages are kept)
+void resolution_update(ResolutionState& state, uint32_t raster_us, uint32_t target_us, bool adapt);
+
+// Viewport side of the current step
+inline int resolution_size(const ResolutionState& state) { return RESOLUTION_STEPS[state.step]; }
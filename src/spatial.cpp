@@ -0,0 +1,61 @@
+#include "spatial.hpp"
+#include <cmath>
+
+static inline int cell_coord(float v) {
+    return (int)floorf(v / SPATIAL_CELL_SIZE);
+}
+
+static inline uint32_t cell_bucket(int cx, int cz) {
+    return ((uint32_t)cx * 73856093u ^ (uint32_t)cz * 19349663u) & (SPATIAL_BUCKETS - 1);
+}
+
+void spatial_init(SpatialHash& hash, int16_t* next, uint8_t* bucket, int capacity) {
+    for (int i = 0; i < SPATIAL_BUCKETS; i++) hash.heads[i] = -1;
+    hash.next = next;
+    hash.bucket = bucket;
+    hash.capacity = capacity;
+    for (int i = 0; i < capacity; i++) next[i] = -1;
+}
+
+void spatial_insert(SpatialHash& hash, int id, float x, float z) {
+    uint32_t b = cell_bucket(cell_coord(x), cell_coord(z));
+    hash.bucket[id] = (uint8_t)b;
+    hash.next[id] = hash.heads[b];
+    hash.heads[b] = (int16_t)id;
+}
+
+void spatial_remove(SpatialHash& hash, int id) {
+    int16_t* link = &hash.heads[hash.bucket[id]];
+    while (*link >= 0) {
+        if (*link == id) {
+            *link = hash.next[id];
+            hash.next[id] = -1;
+            return;
+        }
+        link = &hash.next[*link];
+    }
+}
+
+int spatial_query_aabb(const SpatialHash& hash, float min_x, float min_z, float max_x, float max_z,
+                       int16_t* out, int max_out) {
+    int cx0 = cell_coord(min_x), cx1 = cell_coord(max_x);
+    int cz0 = cell_coord(min_z), cz1 = cell_coord(max_z);
+
+    // Different cells can hash to the same bucket; visit each bucket once
+    uint32_t seen[SPATIAL_BUCKETS / 32] = {};
+    int count = 0;
+
+    for (int cz = cz0; cz <= cz1; cz++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            uint32_t b = cell_bucket(cx, cz);
+            if (seen[b >> 5] & (1u << (b & 31))) continue;
+            seen[b >> 5] |= 1u << (b & 31);
+
+            for (int16_t id = hash.heads[b]; id >= 0; id = hash.next[id]) {
+                if (count >= max_out) return count;
+                out[count++] = id;
+            }
+        }
+    }
+    return count;
+}
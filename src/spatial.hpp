@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+// Uniform-grid spatial hash over object indices on the XZ plane.
+// Objects live in the caller's arrays; the hash only links their indices.
+// Each object is inserted by its centre point, so queries must be expanded
+// by the largest object half-extent (a "loose" grid).
+
+constexpr float SPATIAL_CELL_SIZE = 4.0f;  // World units per grid cell
+constexpr int SPATIAL_BUCKETS = 256;       // Hash buckets (power of two, fits the uint8_t bucket links)
+
+struct SpatialHash {
+    int16_t heads[SPATIAL_BUCKETS];  // First object in each bucket (-1 = empty)
+    int16_t* next;                   // Next object in the same bucket, one per object
+    uint8_t* bucket;                 // Bucket each object is linked into, one per object
+    int capacity;
+};
+
+// Set up an empty hash over caller-provided link arrays of `capacity` entries
+void spatial_init(SpatialHash& hash, int16_t* next, uint8_t* bucket, int capacity);
+
+// Link object `id` into the cell containing (x, z)
+void spatial_insert(SpatialHash& hash, int id, float x, float z);
+
+// Unlink object `id` (must have been inserted)
+void spatial_remove(SpatialHash& hash, int id);
+
+// Collect candidate objects whose cells overlap the AABB [min, max].
+// Candidates still need an exact test. Returns the number written to out.
+int spatial_query_aabb(const SpatialHash& hash, float min_x, float min_z, float max_x, float max_z,
+                       int16_t* out, int max_out);
+
+// Candidates around a point within `radius` (AABB of the circle)
+inline int spatial_query_radius(const SpatialHash& hash, float x, float z, float radius,
+                                int16_t* out, int max_out) {
+    return spatial_query_aabb(hash, x - radius, z - radius, x + radius, z + radius, out, max_out);
+}
+
+// Candidates in the cell containing a point
+inline int spatial_query_point(const SpatialHash& hash, float x, float z, int16_t* out, int max_out) {
+    return spatial_query_aabb(hash, x, z, x, z, out, max_out);
+}
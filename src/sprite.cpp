@@ -0,0 +1,68 @@
+#include "sprite.hpp"
+
+void sprite_draw(const Sprite& sprite, int x, int y, float scale, uint8_t depth, bool flip_x, color_t* fb) {
+    // Sprite pixel edges map to screen pixels through a 16.16 step, so every
+    // run becomes one screen span per covered row
+    int32_t step = (int32_t)(scale * 65536.0f);
+    if (step <= 0) return;
+    int origin_x = flip_x ? sprite.width - sprite.origin_x : sprite.origin_x;
+    int left = x - ((origin_x * step) >> 16);
+    int top = y - ((sprite.origin_y * step) >> 16);
+
+    // Runs are mostly a pixel or two long, so the row mapping and clipping
+    // are done once per sprite row, and rows that map to no screen row (when
+    // scaled down) are passed over without touching their runs
+    int xs[2][SPRITE_MAX_ROW_SPANS];
+    color_t colors[SPRITE_MAX_ROW_SPANS];
+    int i = 0;
+    while (i < sprite.span_count) {
+        int sprite_y = sprite.spans[i].y;
+        int y0 = top + ((sprite_y * step) >> 16);
+        int y1 = top + (((sprite_y + 1) * step) >> 16);
+        if (y0 >= SCREEN_HEIGHT) break;
+        if (y0 < 0) y0 = 0;
+        if (y1 > SCREEN_HEIGHT) y1 = SCREEN_HEIGHT;
+        if (y0 >= y1) {
+            while (i < sprite.span_count && sprite.spans[i].y == sprite_y) i++;
+            continue;
+        }
+
+        int count = 0;
+        for (; i < sprite.span_count && sprite.spans[i].y == sprite_y; i++) {
+            const SpriteSpan& span = sprite.spans[i];
+            int sx = flip_x ? sprite.width - span.x - span.length : span.x;
+            int x0 = left + ((sx * step) >> 16);
+            int x1 = left + (((sx + span.length) * step) >> 16);
+            if (x0 < 0) x0 = 0;
+            if (x1 > SCREEN_WIDTH) x1 = SCREEN_WIDTH;
+            if (x0 >= x1 || count == SPRITE_MAX_ROW_SPANS) continue;
+            xs[0][count] = x0;
+            xs[1][count] = x1;
+            colors[count++] = sprite.palette[span.color];
+        }
+
+        for (int py = y0; py < y1; py++) {
+            uint8_t* depth_row = &depth_buffer_display[py * DEPTH_WIDTH];
+            for (int k = 0; k < count; k++) {
+                color_t color = colors[k];
+                if (fb) {
+                    color_t* row = &fb[py * SCREEN_WIDTH];
+                    for (int px = xs[0][k]; px < xs[1][k]; px++) {
+                        if (depth < depth_row[px]) {
+                            depth_row[px] = depth;
+                            row[px] = color;
+                        }
+                    }
+                } else {
+                    pen(color);
+                    for (int px = xs[0][k]; px < xs[1][k]; px++) {
+                        if (depth < depth_row[px]) {
+                            depth_row[px] = depth;
+                            pixel(px, py);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "render3d.hpp"
+
+// Pixel-art sprites stored as opaque runs of one colour, drawn as scaled,
+// depth-tested billboards (transparent pixels cost nothing)
+
+struct SpriteSpan {
+    uint8_t y, x;     // First pixel of the run
+    uint8_t length;
+    uint8_t color;    // Index into the sprite's palette
+};
+
+// Opaque runs a sprite row may have (sprite_draw maps a row's runs together)
+constexpr int SPRITE_MAX_ROW_SPANS = 16;
+
+struct Sprite {
+    uint8_t width, height;
+    uint8_t origin_x, origin_y;  // Pixel placed at the billboard's screen position
+    const SpriteSpan* spans;     // Sorted by row
+    uint16_t span_count;
+    const color_t* palette;
+};
+
+// Sprites are baked from assets/*.png by tools/bake_images.py into images.hpp
+// (e.g. chicken_sprites, the walk cycle: facing left, feet at the origin)
+
+// Draw a sprite scaled by `scale` screen pixels per sprite pixel (nearest
+// neighbour), with its origin at (x, y). Pixels are drawn where `depth` is
+// nearer than depth_buffer_display, like the other billboards.
+// fb = framebuffer to draw to, nullptr = use pen/pixel
+void sprite_draw(const Sprite& sprite, int x, int y, float scale, uint8_t depth, bool flip_x, color_t* fb);
@@ -0,0 +1,38 @@
+#include "texture.hpp"
+#include "rasterizer.hpp"
+#include "images.hpp"
+
+static_assert(BRICK_SIZE_LOG2 == TEXTURE_BRICK_LOG2, "assets/brick.png doesn't match TEXTURE_BRICK_LOG2");
+constexpr int BRICK_SIZE = 1 << TEXTURE_BRICK_LOG2;
+static_assert(TEXTURE_BRICK + RENDER3D_FOG_LEVELS * RENDER3D_FOG_TEXTURE_STRIDE <= RASTER_MAX_TEXTURES,
+              "brick texture slots don't fit");
+
+// The brick colour (the most used, brick_colors[0]) is mapped to the red brick
+// building wall colour and the rest scaled with it, so textured and flat
+// (distant) walls match
+static const uint8_t brick_tint[3] = {180, 100, 100};
+
+static color_t brick_textures[RENDER3D_FOG_LEVELS][4][BRICK_SIZE * BRICK_SIZE];
+
+void texture_init() {
+    for (int face = 0; face < 4; face++) {
+        float shade = RENDER3D_SIDE_SHADE[face];
+        for (int i = 0; i < BRICK_SIZE * BRICK_SIZE; i++) {
+            const uint8_t* c = brick_colors[brick_texels[i]];
+            uint8_t rgb[3];
+            for (int k = 0; k < 3; k++) {
+                int value = (int)(c[k] * brick_tint[k] / brick_colors[0][k] * shade);
+                rgb[k] = (uint8_t)(value > 255 ? 255 : value);
+            }
+            for (int level = 0; level < RENDER3D_FOG_LEVELS; level++) {
+                uint8_t r = rgb[0], g = rgb[1], b = rgb[2];
+                render3d_fog_rgb((uint8_t)level, r, g, b);
+                brick_textures[level][face][i] = rgb_to_color(r, g, b);
+            }
+        }
+        for (int level = 0; level < RENDER3D_FOG_LEVELS; level++) {
+            rasterizer_set_texture(TEXTURE_BRICK + level * RENDER3D_FOG_TEXTURE_STRIDE + face,
+                                   brick_textures[level][face], TEXTURE_BRICK_LOG2);
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "render3d.hpp"
+
+// Wall textures, baked from assets and pre-converted to color_t. Each takes
+// one rasterizer slot per side-face shade (RENDER3D_SIDE_SHADE) and fog level
+// below RENDER3D_FOG_LEVELS, starting at its id (see render3d_textured_triangle).
+
+constexpr int TEXTURE_BRICK = 0;       // assets/brick.png tinted to the red brick building colour
+constexpr int TEXTURE_BRICK_LOG2 = 4;  // 16x16
+
+// Convert the textures and register them with the rasterizer (call once at startup)
+void texture_init();
@@ -0,0 +1,271 @@
+// Host benchmark test: the seeded scenes against their reference images and
+// host baselines, then the comparisons that need no device: rasterizer
+// backends on the captured frames, the synthetic sweep (Gouraud against
+// textured), dynamic resolution and the building store. Exits non-zero if a
+// scene fails or the backends disagree.
+#include "benchmark.hpp"
+#include "city.hpp"
+#include "texture.hpp"
+#include <cstdio>
+#include <algorithm>
+#include <cmath>
+
+static color_t fb[SCREEN_WIDTH * SCREEN_HEIGHT];
+
+static const char* backend_names[RASTER_BACKEND_COUNT] = {"edge", "scanline"};
+
+// A run that fails only on time is retried, as another process can take the CPU
+constexpr int SCENE_RUNS = 3;
+
+static bool run_scenes() {
+    static BenchmarkResult results[BENCHMARK_SCENES];
+    bool passed = false, images_ok = true;
+    for (int run = 0; run < SCENE_RUNS && !passed && images_ok; run++) {
+        passed = benchmark_run(fb, results);
+        for (int i = 0; i < BENCHMARK_SCENES; i++) images_ok = images_ok && results[i].image_ok;
+    }
+    printf("scene  build_us  raster_us  triangles  max_error  bad_cells\n");
+    for (int i = 0; i < BENCHMARK_SCENES; i++) {
+        const BenchmarkResult& r = results[i];
+        printf("%5d  %8u  %9u  %9u  %9d  %9d%s%s\n", i, r.build_us, r.raster_us, r.triangles,
+               r.max_error, r.bad_cells, r.image_ok ? "" : "  IMAGE", r.time_ok ? "" : "  TIME");
+    }
+    return passed;
+}
+
+static bool compare_backends() {
+    static BackendComparison results[BENCHMARK_SCENES];
+    benchmark_compare_backends(fb, results);
+    bool identical = true;
+    printf("\nscene  triangles");
+    for (int b = 0; b < RASTER_BACKEND_COUNT; b++) printf("  %9s", backend_names[b]);
+    printf("  max_error\n");
+    for (int i = 0; i < BENCHMARK_SCENES; i++) {
+        const BackendComparison& r = results[i];
+        printf("%5d  %9u", i, r.triangles);
+        for (int b = 0; b < RASTER_BACKEND_COUNT; b++) printf("  %9u", r.raster_us[b]);
+        printf("  %9d%s\n", r.max_error, r.identical ? "" : "  DIFFERENT");
+        identical = identical && r.identical;
+    }
+    return identical;
+}
+
+static void stress_sweep() {
+    static const char* shading_names[] = {"flat", "gouraud", "textured"};
+    static const char* order_names[] = {"random", "front_to_back", "back_to_front"};
+    printf("\n leg  overdraw  shading   order          triangles  ns/triangle  ns/pixel\n");
+    for (int i = 0; i < BENCHMARK_STRESS_SWEEP; i++) {
+        const StressWorkload& w = benchmark_stress_sweep[i];
+        StressResult r;
+        benchmark_stress(w, fb, r);
+        printf("%4d  %8d  %-8s  %-13s  %9u  %11u  %8u\n", w.leg, w.overdraw, shading_names[w.shading],
+               order_names[w.order], r.triangles, r.ns_per_triangle, r.ns_per_pixel);
+    }
+}
+
+// Dynamic resolution held at 120 against adapting, with the target at the
+// paths' mean full-resolution time: as heavy for the controller as scenes
+// near 60 FPS are on the device
+static void dynamic_resolution() {
+    ResolutionRun fixed, adaptive;
+    benchmark_resolution(fb, UINT32_MAX, false, fixed);
+    uint32_t target_us = fixed.mean_us;
+    benchmark_resolution(fb, target_us, false, fixed);
+    benchmark_resolution(fb, target_us, true, adaptive);
+    printf("\ndynamic resolution  mean_us  deviation_us  max_us  over_target  smallest  (target %u us, %d frames)\n",
+           target_us, BENCHMARK_SCENES * BENCHMARK_RESOLUTION_FRAMES);
+    const ResolutionRun* runs[2] = {&fixed, &adaptive};
+    for (int i = 0; i < 2; i++) {
+        const ResolutionRun& r = *runs[i];
+        printf("%-18s  %7u  %12u  %6u  %11u  %8d\n", i ? "on" : "off", r.mean_us, r.deviation_us, r.max_us,
+               r.over_target, r.smallest);
+    }
+}
+
+// The building layout before the structure-of-arrays store: world floats
+// and colours per building, slot * MAX_BUILDINGS_PER_CHUNK + i
+struct FloatBuilding {
+    float x, z, width, depth, height;
+    uint8_t r_roof, g_roof, b_roof, r_wall, g_wall, b_wall;
+};
+
+// Both layouts of the same buildings, filled from the window's chunks
+static FloatBuilding float_buildings[MAX_BUILDINGS];
+static BuildingStore fixed_buildings;
+static int slot_count[CITY_WINDOW_SLOTS];
+static int slot_cx[CITY_WINDOW_SLOTS], slot_cz[CITY_WINDOW_SLOTS];
+
+static void fill_layouts(float x, float z) {
+    ChunkBuildingParams params;
+    int camera_cx = city_chunk_of(x), camera_cz = city_chunk_of(z);
+    for (int cz = camera_cz - city_window_radius; cz <= camera_cz + city_window_radius; cz++) {
+        for (int cx = camera_cx - city_window_radius; cx <= camera_cx + city_window_radius; cx++) {
+            int slot = city_window_slot(cx, cz), count = 0;
+            slot_cx[slot] = cx;
+            slot_cz[slot] = cz;
+            city_generate_building_params(cx, cz, params);
+            for (int i = 0; i < CITY_BUILDING_SITES && count < MAX_BUILDINGS_PER_CHUNK; i++) {
+                if (!params.present[i]) continue;
+                int id = slot * MAX_BUILDINGS_PER_CHUNK + count++;
+                fixed_buildings.x[id] = params.x[i];
+                fixed_buildings.z[id] = params.z[i];
+                fixed_buildings.half_width[id] = params.half_width[i];
+                fixed_buildings.half_depth[id] = params.half_depth[i];
+                fixed_buildings.height[id] = params.height[i];
+                fixed_buildings.color[id] = params.color[i];
+
+                FloatBuilding& b = float_buildings[id];
+                b.x = (float)(cx * CITY_CHUNK_SIZE_FIXED + params.x[i]) / CITY_FIXED_ONE;
+                b.z = (float)(cz * CITY_CHUNK_SIZE_FIXED + params.z[i]) / CITY_FIXED_ONE;
+                b.width = 2.0f * params.half_width[i] / CITY_FIXED_ONE;
+                b.depth = 2.0f * params.half_depth[i] / CITY_FIXED_ONE;
+                b.height = (float)params.height[i] / CITY_FIXED_ONE;
+            }
+            slot_count[slot] = count;
+        }
+    }
+}
+
+// Collision of a circle with every building of the window, as each layout's
+// city_check_collision tests a candidate
+static uint32_t collide_float(float x, float z, float radius) {
+    uint32_t hits = 0;
+    for (int slot = 0; slot < CITY_WINDOW_SLOTS; slot++) {
+        for (int id = slot * MAX_BUILDINGS_PER_CHUNK; id < slot * MAX_BUILDINGS_PER_CHUNK + slot_count[slot]; id++) {
+            const FloatBuilding& b = float_buildings[id];
+            float half_w = b.width / 2 + radius, half_d = b.depth / 2 + radius;
+            hits += fabsf(x - b.x) < half_w && fabsf(z - b.z) < half_d;
+        }
+    }
+    return hits;
+}
+
+static uint32_t collide_fixed(float x, float z, float radius) {
+    uint32_t hits = 0;
+    int32_t fx = (int32_t)(x * CITY_FIXED_ONE), fz = (int32_t)(z * CITY_FIXED_ONE);
+    int32_t fr = (int32_t)(radius * CITY_FIXED_ONE);
+    for (int slot = 0; slot < CITY_WINDOW_SLOTS; slot++) {
+        int32_t ox = fx - slot_cx[slot] * CITY_CHUNK_SIZE_FIXED, oz = fz - slot_cz[slot] * CITY_CHUNK_SIZE_FIXED;
+        for (int id = slot * MAX_BUILDINGS_PER_CHUNK; id < slot * MAX_BUILDINGS_PER_CHUNK + slot_count[slot]; id++) {
+            int32_t dx = ox - fixed_buildings.x[id], dz = oz - fixed_buildings.z[id];
+            hits += abs(dx) < fixed_buildings.half_width[id] + fr && abs(dz) < fixed_buildings.half_depth[id] + fr;
+        }
+    }
+    return hits;
+}
+
+// Buildings of the window in view, as each layout's city_render culls them
+static uint32_t cull_float() {
+    uint32_t visible = 0;
+    for (int slot = 0; slot < CITY_WINDOW_SLOTS; slot++) {
+        for (int id = slot * MAX_BUILDINGS_PER_CHUNK; id < slot * MAX_BUILDINGS_PER_CHUNK + slot_count[slot]; id++) {
+            const FloatBuilding& b = float_buildings[id];
+            float half_w = b.width / 2, half_d = b.depth / 2;
+            visible += render3d_visible_xz(b.x - half_w, b.z - half_d, b.x + half_w, b.z + half_d, city_draw_distance);
+        }
+    }
+    return visible;
+}
+
+static uint32_t cull_fixed() {
+    float camera_x, camera_z, apex_x, apex_z, normals[2][2];
+    render3d_camera_xz(camera_x, camera_z);
+    render3d_view_wedge(apex_x, apex_z, normals);
+    int32_t nx[2], nz[2];
+    for (int p = 0; p < 2; p++) {
+        nx[p] = (int32_t)(normals[p][0] * 1024.0f);
+        nz[p] = (int32_t)(normals[p][1] * 1024.0f);
+    }
+    float max_dist = city_draw_distance * CITY_FIXED_ONE;
+    int32_t max_dist_sq = (int32_t)(max_dist * max_dist);
+
+    uint32_t visible = 0;
+    for (int slot = 0; slot < CITY_WINDOW_SLOTS; slot++) {
+        // The view rebased to the chunk's corner once, then integer tests
+        float origin_x = slot_cx[slot] * CITY_CHUNK_SIZE, origin_z = slot_cz[slot] * CITY_CHUNK_SIZE;
+        int32_t cam_x = (int32_t)((camera_x - origin_x) * CITY_FIXED_ONE);
+        int32_t cam_z = (int32_t)((camera_z - origin_z) * CITY_FIXED_ONE);
+        int32_t ap_x = (int32_t)((apex_x - origin_x) * CITY_FIXED_ONE);
+        int32_t ap_z = (int32_t)((apex_z - origin_z) * CITY_FIXED_ONE);
+        for (int id = slot * MAX_BUILDINGS_PER_CHUNK; id < slot * MAX_BUILDINGS_PER_CHUNK + slot_count[slot]; id++) {
+            int32_t x = fixed_buildings.x[id], z = fixed_buildings.z[id];
+            int32_t hw = fixed_buildings.half_width[id], hd = fixed_buildings.half_depth[id];
+            int32_t dx = std::min(std::max(cam_x, x - hw), x + hw) - cam_x;
+            int32_t dz = std::min(std::max(cam_z, z - hd), z + hd) - cam_z;
+            bool in = dx * dx + dz * dz <= max_dist_sq;
+            for (int p = 0; p < 2 && in; p++) {
+                in = nx[p] * (x - ap_x) + nz[p] * (z - ap_z) + abs(nx[p]) * hw + abs(nz[p]) * hd >= 0;
+            }
+            visible += in;
+        }
+    }
+    return visible;
+}
+
+// The old float layout against the fixed-point columns over the same
+// buildings and views, then the city's own collision query and frame build
+static void building_store() {
+    const int views = 16, queries = 400, culls = 200;
+    city_init(777);
+    uint32_t seed = 9, buildings_tested = 0;
+    uint32_t float_collision_us = 0, fixed_collision_us = 0, float_cull_us = 0, fixed_cull_us = 0;
+    uint32_t float_hits = 0, fixed_hits = 0, float_visible = 0, fixed_visible = 0;
+    uint32_t collision_us = 0, render_us = 0, hits = 0;
+    for (int v = 0; v < views; v++) {
+        float x = (city_random(seed) % 4000) / 10.0f - 200.0f;
+        float z = (city_random(seed) % 4000) / 10.0f - 200.0f;
+        float yaw = (city_random(seed) % 628) / 100.0f;
+        for (int i = 0; i < CITY_WINDOW_SLOTS; i++) city_update_chunks(x, z, UINT32_MAX);
+        fill_layouts(x, z);
+        for (int slot = 0; slot < CITY_WINDOW_SLOTS; slot++) buildings_tested += slot_count[slot];
+        render3d_third_person_camera(x, 0.0f, z, yaw);
+
+        uint32_t start = time_us();
+        for (int q = 0; q < queries; q++) float_hits += collide_float(x + (q % 20) - 10.0f, z + (q / 20) - 10.0f, 0.4f);
+        float_collision_us += time_us() - start;
+        start = time_us();
+        for (int q = 0; q < queries; q++) fixed_hits += collide_fixed(x + (q % 20) - 10.0f, z + (q / 20) - 10.0f, 0.4f);
+        fixed_collision_us += time_us() - start;
+
+        start = time_us();
+        for (int c = 0; c < culls; c++) float_visible += cull_float();
+        float_cull_us += time_us() - start;
+        start = time_us();
+        for (int c = 0; c < culls; c++) fixed_visible += cull_fixed();
+        fixed_cull_us += time_us() - start;
+
+        start = time_us();
+        for (int q = 0; q < queries; q++) {
+            hits += city_check_collision(x + (q % 20) - 10.0f, z + (q / 20) - 10.0f, 0.4f);
+        }
+        collision_us += time_us() - start;
+
+        start = time_us();
+        render3d_begin_frame();
+        city_build_occluders();
+        city_render();
+        render_us += time_us() - start;
+    }
+    printf("\nbuilding store: %zu bytes as floats (%zu per building), %zu as columns\n",
+           sizeof(float_buildings), sizeof(FloatBuilding), sizeof(BuildingStore));
+    printf("                 floats     columns  (ns per building, %u buildings over %d views)\n",
+           buildings_tested, views);
+    printf("collision   %9.2f   %9.2f  (%u / %u hits)\n", float_collision_us * 1000.0 / (buildings_tested * queries),
+           fixed_collision_us * 1000.0 / (buildings_tested * queries), float_hits, fixed_hits);
+    printf("culling     %9.2f   %9.2f  (%u / %u visible)\n", float_cull_us * 1000.0 / (buildings_tested * culls),
+           fixed_cull_us * 1000.0 / (buildings_tested * culls), float_visible / culls, fixed_visible / culls);
+    printf("city: collision %u ns/query (%u hits)  frame %u us\n",
+           collision_us * 1000 / (views * queries), hits, render_us / views);
+}
+
+int main() {
+    render3d_init();
+    texture_init();
+    bool passed = run_scenes();
+    bool identical = compare_backends();
+    stress_sweep();
+    dynamic_resolution();
+    building_store();
+    printf("\n%s\n", passed && identical ? "PASS" : "FAIL");
+    return passed && identical ? 0 : 1;
+}
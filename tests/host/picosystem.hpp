@@ -0,0 +1,17 @@
+#pragma once
+// Host stand-in for the PicoSystem SDK, enough for the renderer and the
+// benchmark: drawing through the pen does nothing, time comes from the host clock
+#include <chrono>
+#include <cstdint>
+
+namespace picosystem {
+  typedef uint16_t color_t;
+  inline void pen(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 15) {}
+  inline void pen(color_t p) {}
+  inline void pixel(int32_t x, int32_t y) {}
+  inline uint32_t time_us() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+  inline uint32_t time() { return time_us() / 1000; }
+}
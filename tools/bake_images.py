@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""Bake PNG sprites and textures into const tables for src/sprite.cpp and src/texture.cpp.
+
+Sprites become run-length tables (src/sprite.hpp): each row's opaque pixels
+as runs of one palette colour, sorted by row, with a palette of color_t
+shared by all frames of the sprite. Fully transparent pixels are dropped.
+
+Textures become one palette index per texel, row-major, and a palette of
+8-bit RGB (the game tints and shades it at startup). The palette is sorted
+by how many texels use each colour, most first.
+
+Only the standard library is used, so PNGs are decoded here: 8-bit
+greyscale, RGB, palette and RGBA images, non-interlaced.
+
+Usage: bake_images.py --out-dir DIR
+           [--sprite NAME ORIGIN_X ORIGIN_Y frame.png [frame.png ...]] ...
+           [--texture NAME texture.png] ...
+Writes DIR/images.hpp and DIR/images.cpp. A sprite defines NAME_sprites and
+NAME_FRAMES; a texture defines NAME_texels, NAME_colors and NAME_SIZE_LOG2.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+PNG_SIGNATURE = b"\x89PNG\r\n\x1a\n"
+MAX_ROW_SPANS = 16   # SPRITE_MAX_ROW_SPANS in src/sprite.hpp
+MAX_COLORS = 256
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def load_png(path):
+    """Returns (width, height, rows of (r, g, b, a) pixels)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != PNG_SIGNATURE:
+        sys.exit(f"{path}: not a PNG")
+    pos, idat, palette, alpha = 8, b"", [], []
+    while pos < len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, color_type, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"PLTE":
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            alpha = list(body)
+        elif kind == b"IDAT":
+            idat += body
+        elif kind == b"IEND":
+            break
+    channels = {0: 1, 2: 3, 3: 1, 6: 4}.get(color_type)
+    if depth != 8 or channels is None or interlace:
+        sys.exit(f"{path}: only 8-bit non-interlaced greyscale, RGB, palette or RGBA PNGs are supported")
+
+    raw = zlib.decompress(idat)
+    stride = width * channels
+    rows, previous = [], bytearray(stride)
+    for y in range(height):
+        filter_type = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - channels] if i >= channels else 0
+            b = previous[i]
+            c = previous[i - channels] if i >= channels else 0
+            if filter_type == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif filter_type == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif filter_type == 3:
+                line[i] = (line[i] + (a + b) // 2) & 0xFF
+            elif filter_type == 4:
+                line[i] = (line[i] + paeth(a, b, c)) & 0xFF
+        previous = line
+
+        pixels = []
+        for x in range(width):
+            p = line[x * channels:(x + 1) * channels]
+            if color_type == 0:
+                pixels.append((p[0], p[0], p[0], 255))
+            elif color_type == 2:
+                pixels.append((p[0], p[1], p[2], 255))
+            elif color_type == 3:
+                pixels.append(palette[p[0]] + (alpha[p[0]] if p[0] < len(alpha) else 255,))
+            else:
+                pixels.append(tuple(p))
+        rows.append(pixels)
+    return width, height, rows
+
+
+def size_log2(path, width, height):
+    log2 = width.bit_length() - 1
+    if width != height or width != 1 << log2:
+        sys.exit(f"{path}: textures must be square with a power-of-two size")
+    return log2
+
+
+def bake_sprite(name, origin_x, origin_y, paths):
+    """Returns (header lines, source lines)."""
+    colors, color_index, frames, size = [], {}, [], None
+    for path in paths:
+        width, height, rows = load_png(path)
+        if size and size != (width, height):
+            sys.exit(f"{path}: frames of {name} differ in size")
+        if width > 255 or height > 255:
+            sys.exit(f"{path}: sprites are at most 255 pixels on a side")
+        size = (width, height)
+
+        spans = []
+        for y, row in enumerate(rows):
+            row_spans = 0
+            x = 0
+            while x < width:
+                r, g, b, a = row[x]
+                if a == 0:
+                    x += 1
+                    continue
+                start = x
+                while x < width and x - start < 255 and row[x] == row[start]:
+                    x += 1
+                if (r, g, b) not in color_index:
+                    color_index[(r, g, b)] = len(colors)
+                    colors.append((r, g, b))
+                spans.append((y, start, x - start, color_index[(r, g, b)]))
+                row_spans += 1
+            if row_spans > MAX_ROW_SPANS:
+                sys.exit(f"{path}: row {y} has {row_spans} runs (max {MAX_ROW_SPANS})")
+        frames.append(spans)
+    if len(colors) > MAX_COLORS:
+        sys.exit(f"{name}: {len(colors)} colours (max {MAX_COLORS})")
+
+    files = ", ".join(os.path.basename(p) for p in paths)
+    runs = sum(len(s) for s in frames)
+    header = [
+        f"// {files}: {size[0]}x{size[1]}, {runs} runs, {len(colors)} colours",
+        f"constexpr int {name.upper()}_FRAMES = {len(frames)};",
+        f"extern const Sprite {name}_sprites[{name.upper()}_FRAMES];",
+        "",
+    ]
+    source = [f"static constexpr color_t {name}_palette[] = {{"]
+    source += [f"    rgb_to_color({r}, {g}, {b})," for r, g, b in colors]
+    source += ["};", ""]
+    for i, spans in enumerate(frames):
+        source.append(f"static const SpriteSpan {name}{i + 1}_spans[] = {{")
+        for y in sorted(set(s[0] for s in spans)):
+            source.append("    " + " ".join("{%d, %d, %d, %d}," % s for s in spans if s[0] == y))
+        source += ["};", ""]
+    source.append(f"const Sprite {name}_sprites[{name.upper()}_FRAMES] = {{")
+    for i, spans in enumerate(frames):
+        source.append(f"    {{{size[0]}, {size[1]}, {origin_x}, {origin_y}, {name}{i + 1}_spans, "
+                      f"{len(spans)}, {name}_palette}},")
+    source += ["};", ""]
+    return header, source
+
+
+def bake_texture(name, path):
+    """Returns (header lines, source lines)."""
+    width, height, rows = load_png(path)
+    log2 = size_log2(path, width, height)
+    pixels = [(r, g, b) for row in rows for r, g, b, _ in row]
+    colors = sorted(set(pixels), key=lambda c: (-pixels.count(c), pixels.index(c)))
+    if len(colors) > MAX_COLORS:
+        sys.exit(f"{path}: {len(colors)} colours (max {MAX_COLORS})")
+    index = {c: i for i, c in enumerate(colors)}
+
+    header = [
+        f"// {os.path.basename(path)}: {width}x{height}, {len(colors)} colours",
+        f"constexpr int {name.upper()}_SIZE_LOG2 = {log2};",
+        f"extern const uint8_t {name}_texels[{width * height}];   // Indices into {name}_colors",
+        f"extern const uint8_t {name}_colors[{len(colors)}][3];   // Most used first",
+        "",
+    ]
+    source = [f"const uint8_t {name}_texels[{width * height}] = {{"]
+    for y in range(height):
+        source.append("    " + " ".join(f"{index[p]}," for p in pixels[y * width:(y + 1) * width]))
+    source += ["};", "", f"const uint8_t {name}_colors[{len(colors)}][3] = {{"]
+    source += [f"    {{{r}, {g}, {b}}}," for r, g, b in colors]
+    source += ["};", ""]
+    return header, source
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--out-dir", required=True)
+    parser.add_argument("--sprite", nargs="+", action="append", default=[],
+                        metavar=("NAME", "ORIGIN_X ORIGIN_Y FRAME"))
+    parser.add_argument("--texture", nargs=2, action="append", default=[], metavar=("NAME", "PNG"))
+    args = parser.parse_args()
+
+    header = ["// Generated by tools/bake_images.py, do not edit", "#pragma once", '#include "sprite.hpp"', ""]
+    source = ["// Generated by tools/bake_images.py, do not edit", '#include "images.hpp"', ""]
+    for sprite in args.sprite:
+        if len(sprite) < 4:
+            sys.exit("--sprite needs NAME ORIGIN_X ORIGIN_Y and at least one frame")
+        h, s = bake_sprite(sprite[0], int(sprite[1]), int(sprite[2]), sprite[3:])
+        header += h
+        source += s
+    for name, path in args.texture:
+        h, s = bake_texture(name, path)
+        header += h
+        source += s
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    for filename, lines in (("images.hpp", header), ("images.cpp", source)):
+        path = os.path.join(args.out_dir, filename)
+        text = "\n".join(lines).rstrip("\n") + "\n"
+        # Leave unchanged outputs alone so dependents aren't rebuilt
+        if os.path.exists(path) and open(path).read() == text:
+            continue
+        with open(path, "w") as f:
+            f.write(text)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Bake Wavefront OBJ meshes into the binary mesh format read by src/mesh.cpp.
+
+Each mesh becomes one 4-byte aligned, little-endian blob, emitted as a const
+array so it stays in flash (XIP) on the device and in the read-only image on
+the host; mesh_load() only points into it. Layout:
+
+    header   char magic[4] = "MSH1"
+             u16 vertex_count, u16 face_count
+             u8  color_count, u8 pad[3]
+             i16 bounds_min[3], i16 bounds_max[3]   (world units * 256)
+    vertices u8 x, y, z per vertex, quantized within the bounds (0 = min, 255 = max)
+             padded to 4 bytes
+    faces    u8 a, b, c, color per triangle (front faces counter-clockwise, as in OBJ)
+    colors   u8 r, g, b per colour, padded to 4 bytes
+
+Face colours come from the material's Kd, pre-shaded by the face normal (so
+lighting survives any yaw) and shared between faces through the colour list.
+
+Usage: bake_meshes.py --out-dir DIR mesh.obj [mesh.obj ...]
+Writes DIR/meshes.hpp and DIR/meshes.cpp with one mesh_<name>_data per file.
+"""
+
+import argparse
+import math
+import os
+import struct
+import sys
+
+MAGIC = b"MSH1"
+POSITION_ONE = 256   # Bounds units per world unit
+MAX_VERTICES = 128   # MESH_MAX_VERTICES in src/mesh.hpp
+MAX_COLORS = 255
+
+
+def load_materials(path):
+    materials = {}
+    name = None
+    with open(path) as f:
+        for line in f:
+            parts = line.split()
+            if not parts:
+                continue
+            if parts[0] == "newmtl":
+                name = parts[1]
+                materials[name] = (1.0, 1.0, 1.0)
+            elif parts[0] == "Kd" and name:
+                materials[name] = tuple(float(v) for v in parts[1:4])
+    return materials
+
+
+def load_obj(path):
+    vertices, faces, materials = [], [], {}
+    material = None
+    with open(path) as f:
+        for line in f:
+            parts = line.split()
+            if not parts:
+                continue
+            if parts[0] == "mtllib":
+                materials.update(load_materials(os.path.join(os.path.dirname(path), parts[1])))
+            elif parts[0] == "usemtl":
+                material = parts[1]
+            elif parts[0] == "v":
+                vertices.append(tuple(float(v) for v in parts[1:4]))
+            elif parts[0] == "f":
+                # v, v/vt, v/vt/vn or v//vn; polygons are fanned into triangles
+                ids = [int(p.split("/")[0]) for p in parts[1:]]
+                ids = [i - 1 if i > 0 else len(vertices) + i for i in ids]
+                for k in range(1, len(ids) - 1):
+                    faces.append((ids[0], ids[k], ids[k + 1], material))
+    return vertices, faces, materials
+
+
+def face_shade(a, b, c):
+    u = [b[i] - a[i] for i in range(3)]
+    v = [c[i] - a[i] for i in range(3)]
+    n = (u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0])
+    length = math.sqrt(sum(x * x for x in n)) or 1.0
+    # Tops full brightness, walls 0.8, undersides 0.6
+    return 0.8 + 0.2 * n[1] / length
+
+
+def bake(path):
+    vertices, faces, materials = load_obj(path)
+    if not vertices or not faces:
+        sys.exit(f"{path}: no geometry")
+    if len(vertices) > MAX_VERTICES:
+        sys.exit(f"{path}: {len(vertices)} vertices (max {MAX_VERTICES})")
+
+    lo = [min(v[i] for v in vertices) for i in range(3)]
+    hi = [max(v[i] for v in vertices) for i in range(3)]
+    bounds_min = [math.floor(x * POSITION_ONE) for x in lo]
+    bounds_max = [math.ceil(x * POSITION_ONE) for x in hi]
+    for b in bounds_min + bounds_max:
+        if not -32768 <= b <= 32767:
+            sys.exit(f"{path}: bounds out of range")
+
+    def quantize(x, i):
+        extent = bounds_max[i] - bounds_min[i]
+        return 0 if extent == 0 else round((x * POSITION_ONE - bounds_min[i]) * 255 / extent)
+
+    colors, color_index, face_data = [], {}, []
+    for a, b, c, material in faces:
+        kd = materials.get(material, (1.0, 1.0, 1.0))
+        shade = face_shade(vertices[a], vertices[b], vertices[c])
+        rgb = tuple(min(255, round(k * shade * 255)) for k in kd)
+        if rgb not in color_index:
+            color_index[rgb] = len(colors)
+            colors.append(rgb)
+        face_data.append((a, b, c, color_index[rgb]))
+    if len(colors) > MAX_COLORS:
+        sys.exit(f"{path}: {len(colors)} colours (max {MAX_COLORS})")
+
+    def pad4(data):
+        return data + b"\0" * (-len(data) % 4)
+
+    blob = MAGIC + struct.pack("<HHB3x3h3h", len(vertices), len(face_data), len(colors),
+                               *bounds_min, *bounds_max)
+    blob += pad4(b"".join(bytes(quantize(v[i], i) for i in range(3)) for v in vertices))
+    blob += b"".join(bytes(f) for f in face_data)
+    blob += pad4(b"".join(bytes(c) for c in colors))
+    return blob, len(vertices), len(face_data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--out-dir", required=True)
+    parser.add_argument("meshes", nargs="+")
+    args = parser.parse_args()
+
+    header = ["// Generated by tools/bake_meshes.py, do not edit", "#pragma once", "#include <cstdint>", ""]
+    source = ["// Generated by tools/bake_meshes.py, do not edit", '#include "meshes.hpp"', ""]
+    for path in args.meshes:
+        name = os.path.splitext(os.path.basename(path))[0]
+        blob, vertex_count, face_count = bake(path)
+        symbol = f"mesh_{name}_data"
+        header.append(f"// {os.path.basename(path)}: {vertex_count} vertices, {face_count} faces, {len(blob)} bytes")
+        header.append(f"extern const uint8_t {symbol}[{len(blob)}];")
+        source.append(f"alignas(4) const uint8_t {symbol}[{len(blob)}] = {{")
+        for i in range(0, len(blob), 16):
+            source.append("    " + " ".join(f"0x{b:02X}," for b in blob[i:i + 16]))
+        source.append("};")
+        source.append("")
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    for filename, lines in (("meshes.hpp", header), ("meshes.cpp", source)):
+        path = os.path.join(args.out_dir, filename)
+        text = "\n".join(lines).rstrip("\n") + "\n"
+        # Leave unchanged outputs alone so dependents aren't rebuilt
+        if os.path.exists(path) and open(path).read() == text:
+            continue
+        with open(path, "w") as f:
+            f.write(text)
+
+
+if __name__ == "__main__":
+    main()